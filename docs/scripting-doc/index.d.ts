@@ -2867,6 +2867,21 @@ declare class TileLayer extends Layer {
    */
   region() : region
 
+  /**
+   * Returns the connected areas of equal cells in this layer, including
+   * areas of empty cells. The regions are returned in the order in which
+   * they are first encountered, scanning the rows from top to bottom.
+   *
+   * On staggered and hexagonal maps, the adjacency of the map's cells is
+   * used. Otherwise, when `diagonal` is `true`, cells touching at a corner
+   * are also connected. Defaults to `false`.
+   *
+   * On a fixed-size map, only the area of the layer is considered.
+   *
+   * @since 1.11
+   */
+  connectedRegions(diagonal? : boolean) : region[]
+
   /**
    * Resizes the layer, erasing the part of the contents that falls outside of the layer’s new size.
    * The offset parameter can be used to shift the contents by a certain distance in tiles before applying the resize.
@@ -0,0 +1,346 @@
+/*
+ * connectedcomponents.cpp
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of libtiled.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice,
+ *       this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "connectedcomponents.h"
+
+#include "spans.h"
+#include "tilelayer.h"
+
+#include <QtConcurrent>
+
+#include <atomic>
+#include <vector>
+
+using namespace Tiled;
+
+namespace {
+
+constexpr int BAND_ROWS = 64;
+
+/**
+ * A union-find structure, in which the root of each set is its smallest
+ * element. This way the root is the first element that was encountered.
+ */
+class DisjointSets
+{
+public:
+    explicit DisjointSets(int size)
+        : mParent(size)
+    {
+        for (int i = 0; i < size; ++i)
+            mParent[i] = i;
+    }
+
+    int find(int i)
+    {
+        while (mParent[i] != i) {
+            mParent[i] = mParent[mParent[i]];
+            i = mParent[i];
+        }
+        return i;
+    }
+
+    void unite(int a, int b)
+    {
+        a = find(a);
+        b = find(b);
+        if (a < b)
+            mParent[b] = a;
+        else if (b < a)
+            mParent[a] = b;
+    }
+
+private:
+    std::vector<int> mParent;
+};
+
+struct Band
+{
+    int top;            // first row, relative to the bounds
+    int rows;
+    int count = 0;      // number of components in this band
+    int offset = 0;     // index of the first component in the joined sets
+};
+
+/**
+ * Determines the horizontal offsets of the cells on the previous row that
+ * are adjacent to the cell at \a x, \a y. Returns the number of offsets.
+ */
+int aboveNeighbors(ConnectedComponents::Connectivity connectivity,
+                   Map::StaggerAxis staggerAxis,
+                   Map::StaggerIndex staggerIndex,
+                   int x, int y,
+                   int offsets[3])
+{
+    switch (connectivity) {
+    case ConnectedComponents::FourWay:
+        break;
+    case ConnectedComponents::EightWay:
+        offsets[0] = -1;
+        offsets[1] = 0;
+        offsets[2] = 1;
+        return 3;
+    case ConnectedComponents::Staggered:
+        if (staggerAxis == Map::StaggerY) {
+            const bool rowIsStaggered = (y & 1) ^ staggerIndex;
+            offsets[0] = rowIsStaggered ? 0 : -1;
+            offsets[1] = rowIsStaggered ? 1 : 0;
+            return 2;
+        } else {
+            const bool columnIsStaggered = (x & 1) ^ staggerIndex;
+            if (columnIsStaggered)
+                break;
+
+            offsets[0] = -1;
+            offsets[1] = 0;
+            offsets[2] = 1;
+            return 3;
+        }
+    }
+
+    offsets[0] = 0;
+    return 1;
+}
+
+} // anonymous namespace
+
+/**
+ * Labels the components of \a layer within \a bounds, which are in layer
+ * coordinates.
+ *
+ * For the Staggered connectivity, cells are also connected to their left and
+ * right neighbors, matching the flood fill used by the Bucket Fill Tool.
+ *
+ * The optional \a isCanceled function is called regularly from the threads
+ * doing the labeling. When it returns true, the labeling stops early.
+ */
+ConnectedComponents::ConnectedComponents(const TileLayer &layer,
+                                         const QRect &bounds,
+                                         Connectivity connectivity,
+                                         Map::StaggerAxis staggerAxis,
+                                         Map::StaggerIndex staggerIndex,
+                                         const std::function<bool()> &isCanceled)
+    : mBounds(bounds)
+{
+    if (bounds.isEmpty())
+        return;
+
+    const int width = bounds.width();
+    mLabels.resize(width * bounds.height());
+    int * const allLabels = mLabels.data();
+
+    std::vector<Band> bands;
+    for (int top = 0; top < bounds.height(); top += BAND_ROWS)
+        bands.push_back(Band { top, std::min(BAND_ROWS, bounds.height() - top) });
+
+    auto readRow = [&] (int row, std::vector<Cell> &cells) {
+        const int y = bounds.top() + row;
+        for (int x = 0; x < width; ++x)
+            cells[x] = layer.cellAt(bounds.left() + x, y);
+    };
+
+    // Positions in the layer are used to determine staggering
+    const QPoint layerPos = layer.position();
+
+    auto forEachConnection = [&] (int row,
+                                  const std::vector<Cell> &above,
+                                  const std::vector<Cell> &cells,
+                                  const auto &connect) {
+        const int y = layerPos.y() + bounds.top() + row;
+        int offsets[3];
+
+        for (int x = 0; x < width; ++x) {
+            const int count = aboveNeighbors(connectivity, staggerAxis, staggerIndex,
+                                             layerPos.x() + bounds.left() + x, y,
+                                             offsets);
+
+            for (int i = 0; i < count; ++i) {
+                const int aboveX = x + offsets[i];
+                if (aboveX >= 0 && aboveX < width && cells[x] == above[aboveX])
+                    connect(x, aboveX);
+            }
+        }
+    };
+
+    std::atomic<bool> canceled { false };
+
+    // Label the components within each band
+    QtConcurrent::blockingMap(bands, [&] (Band &band) {
+        int *labels = allLabels + band.top * width;
+        DisjointSets sets(band.rows * width);
+
+        std::vector<Cell> above(width);
+        std::vector<Cell> cells(width);
+
+        for (int row = 0; row < band.rows; ++row) {
+            if (canceled || (isCanceled && isCanceled())) {
+                canceled = true;
+                return;
+            }
+
+            readRow(band.top + row, cells);
+
+            const int rowStart = row * width;
+            for (int x = 1; x < width; ++x)
+                if (cells[x] == cells[x - 1])
+                    sets.unite(rowStart + x, rowStart + x - 1);
+
+            if (row > 0) {
+                forEachConnection(band.top + row, above, cells, [&] (int x, int aboveX) {
+                    sets.unite(rowStart + x, rowStart - width + aboveX);
+                });
+            }
+
+            std::swap(above, cells);
+        }
+
+        // Since the root is the first cell of each component, it has
+        // already been labeled by the time its other cells are reached.
+        for (int i = 0; i < band.rows * width; ++i) {
+            const int root = sets.find(i);
+            labels[i] = root == i ? band.count++ : labels[root];
+        }
+    });
+
+    if (canceled) {
+        mBounds = QRect();
+        mLabels.clear();
+        return;
+    }
+
+    // Join the components connected across the borders between the bands
+    int total = 0;
+    for (Band &band : bands) {
+        band.offset = total;
+        total += band.count;
+    }
+
+    DisjointSets sets(total);
+    std::vector<Cell> above(width);
+    std::vector<Cell> cells(width);
+
+    for (size_t b = 1; b < bands.size(); ++b) {
+        const Band &previous = bands[b - 1];
+        const Band &band = bands[b];
+
+        readRow(band.top - 1, above);
+        readRow(band.top, cells);
+
+        const int *aboveLabels = allLabels + (band.top - 1) * width;
+        const int *labels = allLabels + band.top * width;
+
+        forEachConnection(band.top, above, cells, [&] (int x, int aboveX) {
+            sets.unite(band.offset + labels[x], previous.offset + aboveLabels[aboveX]);
+        });
+    }
+
+    std::vector<int> finalLabels(total);
+    for (int i = 0; i < total; ++i) {
+        const int root = sets.find(i);
+        finalLabels[i] = root == i ? mCount++ : finalLabels[root];
+    }
+
+    QtConcurrent::blockingMap(bands, [&] (const Band &band) {
+        int *labels = allLabels + band.top * width;
+        for (int i = 0; i < band.rows * width; ++i)
+            labels[i] = finalLabels[band.offset + labels[i]];
+    });
+}
+
+/**
+ * Returns the connectivity matching the orientation of the given \a map.
+ */
+ConnectedComponents::Connectivity ConnectedComponents::connectivityFor(const Map *map)
+{
+    switch (map->orientation()) {
+    case Map::Staggered:
+    case Map::Hexagonal:
+        return Staggered;
+    default:
+        return FourWay;
+    }
+}
+
+/**
+ * Returns the region covered by the component with the given \a label.
+ */
+QRegion ConnectedComponents::region(int label) const
+{
+    std::vector<Span> spans;
+
+    const int width = mBounds.width();
+    for (int row = 0; row < mBounds.height(); ++row) {
+        const int *labels = mLabels.constData() + row * width;
+
+        for (int x = 0; x < width; ++x) {
+            if (labels[x] != label)
+                continue;
+
+            const int start = x;
+            while (x + 1 < width && labels[x + 1] == label)
+                ++x;
+
+            spans.push_back(Span { mBounds.top() + row,
+                                   mBounds.left() + start,
+                                   mBounds.left() + x });
+        }
+    }
+
+    return regionFromSpans(spans);
+}
+
+/**
+ * Returns the regions of all components, indexed by their label.
+ */
+QVector<QRegion> ConnectedComponents::regions() const
+{
+    std::vector<std::vector<Span>> spans(mCount);
+
+    const int width = mBounds.width();
+    for (int row = 0; row < mBounds.height(); ++row) {
+        const int *labels = mLabels.constData() + row * width;
+
+        for (int x = 0; x < width;) {
+            const int label = labels[x];
+            const int start = x;
+            while (x < width && labels[x] == label)
+                ++x;
+
+            spans[label].push_back(Span { mBounds.top() + row,
+                                          mBounds.left() + start,
+                                          mBounds.left() + x - 1 });
+        }
+    }
+
+    QVector<QRegion> regions;
+    regions.reserve(mCount);
+    for (std::vector<Span> &componentSpans : spans)
+        regions.append(regionFromSpans(componentSpans));
+
+    return regions;
+}
@@ -0,0 +1,102 @@
+/*
+ * connectedcomponents.h
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of libtiled.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice,
+ *       this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include "map.h"
+#include "tiled_global.h"
+
+#include <QRect>
+#include <QRegion>
+#include <QVector>
+
+#include <functional>
+
+namespace Tiled {
+
+class TileLayer;
+
+/**
+ * Labels the connected areas of equal cells in a tile layer.
+ *
+ * Each cell within the given bounds gets the label of the component it is
+ * part of. Labels are numbered from 0 in the order in which the components
+ * are first encountered, scanning the rows from top to bottom.
+ *
+ * The labeling is done in parallel on bands of rows, which are then joined
+ * using a union-find structure.
+ *
+ * When the labeling is canceled, the result has no bounds and no labels.
+ */
+class TILEDSHARED_EXPORT ConnectedComponents
+{
+public:
+    enum Connectivity {
+        FourWay,        // cells sharing an edge are connected
+        EightWay,       // cells sharing an edge or a corner are connected
+        Staggered,      // adjacency on staggered and hexagonal maps
+    };
+
+    ConnectedComponents() = default;
+    ConnectedComponents(const TileLayer &layer,
+                        const QRect &bounds,
+                        Connectivity connectivity = FourWay,
+                        Map::StaggerAxis staggerAxis = Map::StaggerY,
+                        Map::StaggerIndex staggerIndex = Map::StaggerOdd,
+                        const std::function<bool()> &isCanceled = {});
+
+    static Connectivity connectivityFor(const Map *map);
+
+    const QRect &bounds() const { return mBounds; }
+    int count() const { return mCount; }
+
+    int labelAt(int x, int y) const;
+    int labelAt(QPoint pos) const { return labelAt(pos.x(), pos.y()); }
+
+    QRegion region(int label) const;
+    QVector<QRegion> regions() const;
+
+private:
+    QRect mBounds;
+    QVector<int> mLabels;
+    int mCount = 0;
+};
+
+/**
+ * Returns the label of the component containing the cell at the given
+ * coordinates, or -1 when it is outside of the bounds.
+ */
+inline int ConnectedComponents::labelAt(int x, int y) const
+{
+    if (!mBounds.contains(x, y))
+        return -1;
+
+    return mLabels.at((y - mBounds.top()) * mBounds.width() + (x - mBounds.left()));
+}
+
+} // namespace Tiled
@@ -304,7 +304,8 @@ QPointF HexagonalRenderer::snapToGrid(const QPointF &pixelCoords, int subdivisio
 }
 
 void HexagonalRenderer::drawTileLayer(const RenderTileCallback &renderTile,
-                                      const QRectF &exposed) const
+                                      const QRectF &exposed,
+                                      const ChunkCulling &culling) const
 {
     const RenderParams p(map());
 
@@ -339,9 +340,17 @@ void HexagonalRenderer::drawTileLayer(const RenderTileCallback &renderTile,
             QPoint rowTile = startTile;
             QPoint rowPos = startPos;
 
-            for (; rowPos.x() < exposed.right(); rowTile.rx() += 2) {
+            while (rowPos.x() < exposed.right()) {
+                // Skip the part of the row crossing an empty chunk
+                if (const int skip = culling.emptyRun(rowTile, QPoint(2, 0))) {
+                    rowTile.rx() += skip * 2;
+                    rowPos.rx() += skip * (p.tileWidth + p.sideLengthX);
+                    continue;
+                }
+
                 renderTile(rowTile, rowPos);
 
+                rowTile.rx() += 2;
                 rowPos.rx() += p.tileWidth + p.sideLengthX;
             }
 
@@ -373,9 +382,17 @@ void HexagonalRenderer::drawTileLayer(const RenderTileCallback &renderTile,
             if (p.doStaggerY(startTile.y()))
                 rowPos.rx() += p.columnWidth;
 
-            for (; rowPos.x() < exposed.right(); rowTile.rx()++) {
+            while (rowPos.x() < exposed.right()) {
+                // Skip the part of the row crossing an empty chunk
+                if (const int skip = culling.emptyRun(rowTile, QPoint(1, 0))) {
+                    rowTile.rx() += skip;
+                    rowPos.rx() += skip * (p.tileWidth + p.sideLengthX);
+                    continue;
+                }
+
                 renderTile(rowTile, rowPos);
 
+                rowTile.rx()++;
                 rowPos.rx() += p.tileWidth + p.sideLengthX;
             }
 
@@ -83,7 +83,8 @@ public:
 
     using MapRenderer::drawTileLayer;
     void drawTileLayer(const RenderTileCallback &renderTile,
-                       const QRectF &exposed) const override;
+                       const QRectF &exposed,
+                       const ChunkCulling &culling) const override;
 
     void drawTileSelection(QPainter *painter,
                            const QRegion &region,
@@ -238,7 +238,8 @@ void IsometricRenderer::drawGrid(QPainter *painter, const QRectF &rect,
 }
 
 void IsometricRenderer::drawTileLayer(const RenderTileCallback &renderTile,
-                                      const QRectF &exposed) const
+                                      const QRectF &exposed,
+                                      const ChunkCulling &culling) const
 {
     const int tileWidth = map()->tileWidth();
     const int tileHeight = map()->tileHeight();
@@ -282,6 +283,13 @@ void IsometricRenderer::drawTileLayer(const RenderTileCallback &renderTile,
         QPoint columnItr = rowItr;
 
         for (int x = startPos.x(); x < exposed.right(); x += tileWidth) {
+            // Skip the part of the row crossing an empty chunk
+            if (const int skip = culling.emptyRun(columnItr, QPoint(1, -1))) {
+                columnItr += QPoint(skip, -skip);
+                x += (skip - 1) * tileWidth;
+                continue;
+            }
+
             renderTile(columnItr, QPointF(x, (qreal)y / 2));
 
             // Advance to the next column
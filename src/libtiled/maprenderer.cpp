@@ -37,87 +37,70 @@
 #include "staggeredrenderer.h"
 #include "tile.h"
 #include "tilelayer.h"
+#include "tintedpixmapcache.h"
 
-#include <QCache>
 #include <QPaintEngine>
 #include <QPainter>
 #include <QVector2D>
 
 #include <cmath>
+#include <limits>
 
 using namespace Tiled;
 
-struct TintedKey
-{
-    const qint64 key;
-    const QColor color;
+ChunkCulling::ChunkCulling(const TileLayer *layer)
+    : mLayer(layer)
+{}
 
-    bool operator==(const TintedKey &o) const
-    {
-        return key == o.key && color == o.color;
+/**
+ * Returns the number of tiles, starting at \a tilePos and advancing by
+ * \a step, that fall within the same missing or empty chunk. Returns 0 when
+ * the tile at \a tilePos may need to be rendered.
+ */
+int ChunkCulling::emptyRun(QPoint tilePos, QPoint step) const
+{
+    if (!mLayer)
+        return 0;
+
+    const QPoint localPos = tilePos - mLayer->position();
+    const QPoint chunkPos(localPos.x() >> CHUNK_BITS,
+                          localPos.y() >> CHUNK_BITS);
+
+    // Consecutive tiles are usually in the same chunk
+    if (!mHasLastChunk || chunkPos != mLastChunkPos) {
+        mLastChunkPos = chunkPos;
+        mLastChunkEmpty = isChunkEmpty(chunkPos);
+        mHasLastChunk = true;
     }
-};
 
-#if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
-uint qHash(const TintedKey &key, uint seed) Q_DECL_NOTHROW
-#else
-size_t qHash(const TintedKey &key, size_t seed) Q_DECL_NOTHROW
-#endif
-{
-    auto h = ::qHash(key.key, seed);
-    h = ::qHash(key.color.rgba(), h);
-    return h;
-}
+    if (!mLastChunkEmpty)
+        return 0;
 
-// Borrowed from qpixmapcache.cpp
-static inline qsizetype cost(const QPixmap &pixmap)
-{
-    // make sure to do a 64bit calculation; qsizetype might be smaller
-    const qint64 costKb = static_cast<qint64>(pixmap.width())
-                        * pixmap.height() * pixmap.depth() / (8 * 1024);
-    const qint64 costMax = std::numeric_limits<qsizetype>::max();
-    // a small pixmap should have at least a cost of 1(kb)
-    return static_cast<qsizetype>(qBound(1LL, costKb, costMax));
+    auto stepsWithinChunk = [] (int pos, int step) {
+        const int offset = pos & CHUNK_MASK;
+        if (step > 0)
+            return (CHUNK_SIZE - offset + step - 1) / step;
+        if (step < 0)
+            return offset / -step + 1;
+        return std::numeric_limits<int>::max();
+    };
+
+    return std::min(stepsWithinChunk(localPos.x(), step.x()),
+                    stepsWithinChunk(localPos.y(), step.y()));
 }
 
-static QPixmap tinted(const QPixmap &pixmap, const QColor &color)
+bool ChunkCulling::isChunkEmpty(QPoint chunkPos) const
 {
-    if (!color.isValid() || color == QColor(255, 255, 255, 255) || pixmap.isNull())
-        return pixmap;
-
-    // Cache for up to 100 MB of tinted pixmaps, since tinting is expensive
-    static QCache<TintedKey, QPixmap> cache { 100 * 1024 };
-
-    const TintedKey tintedKey { pixmap.cacheKey(), color };
-    if (auto cached = cache.object(tintedKey))
-        return *cached;
-
-    QPixmap resultImage = pixmap;
-    QPainter painter(&resultImage);
-
-    QColor fullOpacity = color;
-    fullOpacity.setAlpha(255);
-    // tint the final color (this will will mess up the alpha which we will fix
-    // in the next lines)
-    painter.setCompositionMode(QPainter::CompositionMode_Multiply);
-    painter.fillRect(resultImage.rect(), fullOpacity);
-
-    // apply the original alpha to the final image
-    painter.setCompositionMode(QPainter::CompositionMode_DestinationIn);
-    painter.drawPixmap(0, 0, pixmap);
-
-    // apply the alpha of the tint color so that we can use it to make the image
-    // transparent instead of just increasing or decreasing the tint effect
-    painter.setCompositionMode(QPainter::CompositionMode_DestinationIn);
-    painter.fillRect(resultImage.rect(), color);
-
-    painter.end();
-
-    cache.insert(tintedKey, new QPixmap(resultImage), cost(resultImage));
-
-    return resultImage;
+    auto it = mEmptyChunks.find(chunkPos);
+    if (it == mEmptyChunks.end()) {
+        const Chunk *chunk = mLayer->findChunk(chunkPos.x() * CHUNK_SIZE,
+                                               chunkPos.y() * CHUNK_SIZE);
+        it = mEmptyChunks.insert(chunkPos, !chunk || chunk->isEmpty());
+    }
+    return it.value();
 }
 
+
 MapRenderer::~MapRenderer()
 {}
 
@@ -171,7 +154,7 @@ void MapRenderer::drawImageLayer(QPainter *painter,
                                  const QRectF &exposed) const
 {
     painter->save();
-    painter->setBrush(tinted(imageLayer->image(), imageLayer->effectiveTintColor()));
+    painter->setBrush(TintedPixmapCache::tinted(imageLayer->image(), imageLayer->effectiveTintColor()));
     painter->setPen(Qt::NoPen);
     if (exposed.isNull())
         painter->drawRect(boundingRect(imageLayer));
@@ -270,6 +253,7 @@ void MapRenderer::drawTileLayer(QPainter *painter, const TileLayer *layer, const
                 drawMargins.top());
 
     CellRenderer renderer(painter, this, layer->effectiveTintColor());
+    const ChunkCulling culling(layer);
 
     auto tileRenderFunction = [layer, &renderer, tileSize](QPoint tilePos, const QPointF &screenPos) {
         const Cell &cell = layer->cellAt(tilePos - layer->position());
@@ -285,7 +269,7 @@ void MapRenderer::drawTileLayer(QPainter *painter, const TileLayer *layer, const
         }
     };
 
-    drawTileLayer(tileRenderFunction, rect);
+    drawTileLayer(tileRenderFunction, rect, culling);
 }
 
 void MapRenderer::setFlag(RenderFlag flag, bool enabled)
@@ -520,7 +504,7 @@ void CellRenderer::render(const Cell &cell, const QPointF &screenPos, const QSiz
                         fragment.width, fragment.height);
 
     mPainter->setTransform(transform);
-    mPainter->drawPixmap(target, tinted(image, mTintColor), source);
+    mPainter->drawPixmap(target, TintedPixmapCache::tinted(image, mTintColor), source);
     mPainter->setTransform(oldTransform);
 
     // A bit of a hack to still draw tile collision shapes when requested
@@ -545,7 +529,7 @@ void CellRenderer::flush()
 
     mPainter->drawPixmapFragments(mFragments.constData(),
                                   mFragments.size(),
-                                  tinted(mTile->image(), mTintColor));
+                                  TintedPixmapCache::tinted(mTile->image(), mTintColor));
 
     if (mRenderer->flags().testFlag(ShowTileCollisionShapes)
             && mTile->objectGroup()
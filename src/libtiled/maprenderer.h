@@ -34,8 +34,10 @@
 #include <functional>
 #include <memory>
 
+#include <QHash>
 #include <QPainter>
 #include <QPainterPath>
+#include <QPoint>
 
 namespace Tiled {
 
@@ -55,6 +57,31 @@ enum RenderFlag {
 
 Q_DECLARE_FLAGS(RenderFlags, RenderFlag)
 
+/**
+ * Keeps track of which chunks of a tile layer contain any tiles, allowing
+ * renderers to skip over runs of tiles that fall in missing or empty chunks
+ * without looking up each cell.
+ *
+ * A default constructed instance does not cull anything.
+ */
+class TILEDSHARED_EXPORT ChunkCulling
+{
+public:
+    ChunkCulling() = default;
+    explicit ChunkCulling(const TileLayer *layer);
+
+    int emptyRun(QPoint tilePos, QPoint step) const;
+
+private:
+    bool isChunkEmpty(QPoint chunkPos) const;
+
+    const TileLayer *mLayer = nullptr;
+    mutable QHash<QPoint, bool> mEmptyChunks;
+    mutable QPoint mLastChunkPos;
+    mutable bool mLastChunkEmpty = false;
+    mutable bool mHasLastChunk = false;
+};
+
 /**
  * This interface is used for rendering tile layers and retrieving associated
  * metrics. The different implementations deal with different map
@@ -163,8 +190,18 @@ public:
      * \li \c screenPos - The screen position of the cell being rendered.
      * \endlist
      */
+    void drawTileLayer(const RenderTileCallback &renderTile,
+                       const QRectF &exposed) const
+    { drawTileLayer(renderTile, exposed, ChunkCulling()); }
+
+    /**
+     * Like the above, but the callback is not called for tiles that fall
+     * within chunks that \a culling reports as empty. These runs of tiles
+     * are skipped without visiting each position.
+     */
     virtual void drawTileLayer(const RenderTileCallback &renderTile,
-                               const QRectF &exposed) const = 0;
+                               const QRectF &exposed,
+                               const ChunkCulling &culling) const = 0;
 
     /**
      * Draws the tile selection given by \a region in the specified \a color.
@@ -322,7 +359,7 @@ inline QPointF MapRenderer::pixelToScreenCoords(const QPointF &point) const
 /**
  * A utility class for rendering cells.
  */
-class CellRenderer
+class TILEDSHARED_EXPORT CellRenderer
 {
 public:
     enum Origin {
@@ -36,8 +36,11 @@
 #include "maprenderer.h"
 #include "objectgroup.h"
 #include "tilelayer.h"
+#include "tileset.h"
 
+#include <QHash>
 #include <QPainter>
+#include <QtConcurrent>
 
 using namespace Tiled;
 
@@ -120,7 +123,164 @@ static void extendMapRect(QRect &mapBoundingRect, const MapRenderer &renderer)
     mapBoundingRect = rect.toAlignedRect();
 }
 
+QRect MiniMapRenderer::mapBoundingRect(RenderFlags renderFlags) const
+{
+    QRect mapBoundingRect = mRenderer->mapBoundingRect();
+
+    if (renderFlags.testFlag(IncludeOverhangingTiles))
+        extendMapRect(mapBoundingRect, *mRenderer);
+
+    if (!renderFlags.testFlag(IgnoreOffsetsAndImages))
+        mMap->adjustBoundingRectForOffsetsAndImageLayers(mapBoundingRect);
+
+    return mapBoundingRect;
+}
+
+static QRgb tintedColor(QRgb color, const QColor &tintColor)
+{
+    // Multiplies the premultiplied color with the tint color and its alpha
+    const int tintAlpha = tintColor.alpha();
+    const int red = qRed(color) * tintColor.red() / 255 * tintAlpha / 255;
+    const int green = qGreen(color) * tintColor.green() / 255 * tintAlpha / 255;
+    const int blue = qBlue(color) * tintColor.blue() / 255 * tintAlpha / 255;
+    const int alpha = qAlpha(color) * tintAlpha / 255;
+    return qRgba(red, green, blue, alpha);
+}
+
+/**
+ * Draws each tile of an orthogonal \a tileLayer as a single rectangle filled
+ * with the average color of its tile image.
+ *
+ * The colors are written directly into an image of one pixel per tile, which
+ * is then scaled to the size of the layer. The image is filled chunk-wise and
+ * in parallel for each band of chunk rows, which is much faster than drawing
+ * the tiles when they would be scaled down to only a few pixels anyway.
+ */
+static void drawTileColors(QPainter &painter,
+                           const TileLayer *tileLayer,
+                           const QRectF &exposed)
+{
+    const Map *map = tileLayer->map();
+    const int tileWidth = map->tileWidth();
+    const int tileHeight = map->tileHeight();
+    const QPoint layerPos = tileLayer->position();
+
+    QRect area = tileLayer->localBounds();
+    if (!exposed.isNull()) {
+        const QRectF exposedTiles(exposed.x() / tileWidth,
+                                  exposed.y() / tileHeight,
+                                  exposed.width() / tileWidth,
+                                  exposed.height() / tileHeight);
+        area &= exposedTiles.toAlignedRect().translated(-layerPos);
+    }
+    if (area.isEmpty())
+        return;
+
+    QImage colors(area.size(), QImage::Format_ARGB32_Premultiplied);
+    colors.fill(Qt::transparent);
+
+    // Access the pixels only through the raw data, since QImage::scanLine
+    // may not be called from multiple threads.
+    uchar * const bits = colors.bits();
+    const qsizetype bytesPerLine = colors.bytesPerLine();
+
+    const QColor tintColor = tileLayer->effectiveTintColor();
+    const bool tint = tintColor.isValid() && tintColor != Qt::white;
+
+    // Look up the colors up front, since they are computed from the tile
+    // images, which may only be accessed on this thread.
+    QHash<const Tile*, QRgb> averageColors;
+    for (const SharedTileset &tileset : tileLayer->usedTilesets())
+        for (const Tile *tile : tileset->tiles())
+            averageColors.insert(tile, tile->averageColor());
+
+    QVector<int> chunkRows;
+    for (int chunkY = area.top() >> CHUNK_BITS; chunkY <= area.bottom() >> CHUNK_BITS; ++chunkY)
+        chunkRows.append(chunkY);
+
+    auto fillChunkRow = [&] (int chunkY) {
+        const int startY = std::max(chunkY << CHUNK_BITS, area.top());
+        const int endY = std::min((chunkY << CHUNK_BITS) + CHUNK_SIZE - 1, area.bottom());
+
+        for (int chunkX = area.left() >> CHUNK_BITS; chunkX <= area.right() >> CHUNK_BITS; ++chunkX) {
+            const Chunk *chunk = tileLayer->findChunk(chunkX << CHUNK_BITS, chunkY << CHUNK_BITS);
+            if (!chunk)
+                continue;
+
+            const int startX = std::max(chunkX << CHUNK_BITS, area.left());
+            const int endX = std::min((chunkX << CHUNK_BITS) + CHUNK_SIZE - 1, area.right());
+
+            for (int y = startY; y <= endY; ++y) {
+                auto line = reinterpret_cast<QRgb*>(bits + (y - area.top()) * bytesPerLine);
+
+                for (int x = startX; x <= endX; ++x) {
+                    const Tile *tile = chunk->cellAt(x & CHUNK_MASK, y & CHUNK_MASK).tile();
+                    if (!tile)
+                        continue;
+
+                    const QRgb color = averageColors.value(tile);
+                    line[x - area.left()] = tint ? tintedColor(color, tintColor) : color;
+                }
+            }
+        }
+    };
+
+    if (chunkRows.size() > 1)
+        QtConcurrent::blockingMap(chunkRows, fillChunkRow);
+    else
+        fillChunkRow(chunkRows.first());
+
+    const QRectF target((area.x() + layerPos.x()) * tileWidth,
+                        (area.y() + layerPos.y()) * tileHeight,
+                        area.width() * tileWidth,
+                        area.height() * tileHeight);
+
+    painter.drawImage(target, colors);
+}
+
+static QTransform imageTransform(QSize imageSize, const QRect &mapBoundingRect)
+{
+    const QSize mapSize = mapBoundingRect.size();
+
+    // Determine the largest possible scale
+    const qreal scale = qMin(static_cast<qreal>(imageSize.width()) / mapSize.width(),
+                             static_cast<qreal>(imageSize.height()) / mapSize.height());
+
+    // Center the map in the requested size
+    const QSize scaledMapSize = mapSize * scale;
+    const QPointF centerOffset((imageSize.width() - scaledMapSize.width()) / 2,
+                               (imageSize.height() - scaledMapSize.height()) / 2);
+
+    QTransform transform;
+    transform.translate(centerOffset.x(), centerOffset.y());
+    transform.scale(scale, scale);
+    transform.translate(-mapBoundingRect.x(), -mapBoundingRect.y());
+    return transform;
+}
+
+/**
+ * Returns the transform from map pixel coordinates to image coordinates, as
+ * used when rendering the map into an image of the given \a imageSize.
+ */
+QTransform MiniMapRenderer::imageTransform(QSize imageSize, RenderFlags renderFlags) const
+{
+    return ::imageTransform(imageSize, mapBoundingRect(renderFlags));
+}
+
 void MiniMapRenderer::renderToImage(QImage &image, RenderFlags renderFlags) const
+{
+    renderToImage(image, renderFlags, QRect());
+}
+
+/**
+ * Renders the part of the map within \a exposed (in map pixel coordinates)
+ * into the matching part of the \a image, leaving the rest of the image
+ * untouched. When \a exposed is null, the whole image is rendered.
+ *
+ * This allows keeping the image up to date after small changes to the map.
+ */
+void MiniMapRenderer::renderToImage(QImage &image, RenderFlags renderFlags,
+                                    const QRect &exposed) const
 {
     if (!mMap)
         return;
@@ -129,42 +289,46 @@ void MiniMapRenderer::renderToImage(QImage &image, RenderFlags renderFlags) cons
 
     const bool drawObjects = renderFlags.testFlag(RenderFlag::DrawMapObjects);
     const bool drawTileLayers = renderFlags.testFlag(RenderFlag::DrawTileLayers);
+    const bool drawTileColors = renderFlags.testFlag(RenderFlag::DrawTileColors) &&
+            mMap->orientation() == Map::Orthogonal;
     const bool drawImageLayers = renderFlags.testFlag(RenderFlag::DrawImageLayers);
     const bool drawTileGrid = renderFlags.testFlag(RenderFlag::DrawGrid);
     const bool visibleLayersOnly = renderFlags.testFlag(RenderFlag::IgnoreInvisibleLayer);
 
-    QRect mapBoundingRect = mRenderer->mapBoundingRect();
-
-    if (renderFlags.testFlag(IncludeOverhangingTiles))
-        extendMapRect(mapBoundingRect, *mRenderer);
+    const QRect mapBoundingRect = this->mapBoundingRect(renderFlags);
+    const QTransform transform = ::imageTransform(image.size(), mapBoundingRect);
 
-    if (!renderFlags.testFlag(IgnoreOffsetsAndImages))
-        mMap->adjustBoundingRectForOffsetsAndImageLayers(mapBoundingRect);
+    QColor backgroundColor = Qt::transparent;
+    if (renderFlags.testFlag(DrawBackground) && mMap->backgroundColor().isValid())
+        backgroundColor = mMap->backgroundColor();
 
-    QSize mapSize = mapBoundingRect.size();
+    QRectF exposedRect;
+    QRect imageRect = image.rect();
 
-    // Determine the largest possible scale
-    const qreal scale = qMin(static_cast<qreal>(image.width()) / mapSize.width(),
-                             static_cast<qreal>(image.height()) / mapSize.height());
+    if (exposed.isNull()) {
+        image.fill(backgroundColor);
+    } else {
+        // Update whole pixels of the image, to avoid blending the edges
+        imageRect &= transform.mapRect(QRectF(exposed)).toAlignedRect();
+        if (imageRect.isEmpty())
+            return;
 
-    if (renderFlags.testFlag(DrawBackground) && mMap->backgroundColor().isValid())
-        image.fill(mMap->backgroundColor());
-    else
-        image.fill(Qt::transparent);
+        exposedRect = transform.inverted().mapRect(QRectF(imageRect));
+    }
 
     QPainter painter(&image);
-    painter.setRenderHints(QPainter::SmoothPixmapTransform, renderFlags.testFlag(SmoothPixmapTransform));
 
-    // Center the map in the requested size
-    const QSize scaledMapSize = mapSize * scale;
-    const QPointF centerOffset((image.width() - scaledMapSize.width()) / 2,
-                               (image.height() - scaledMapSize.height()) / 2);
+    if (!exposed.isNull()) {
+        painter.setClipRect(imageRect);
+        painter.setCompositionMode(QPainter::CompositionMode_Source);
+        painter.fillRect(imageRect, backgroundColor);
+        painter.setCompositionMode(QPainter::CompositionMode_SourceOver);
+    }
 
-    painter.translate(centerOffset);
-    painter.scale(scale, scale);
-    painter.translate(-mapBoundingRect.topLeft());
+    painter.setRenderHints(QPainter::SmoothPixmapTransform, renderFlags.testFlag(SmoothPixmapTransform));
+    painter.setTransform(transform);
 
-    mRenderer->setPainterScale(scale);
+    mRenderer->setPainterScale(transform.m11());
 
     LayerIterator iterator(mMap);
     while (const Layer *layer = iterator.next()) {
@@ -172,6 +336,7 @@ void MiniMapRenderer::renderToImage(QImage &image, RenderFlags renderFlags) cons
             continue;
 
         const auto offset = layer->totalOffset();
+        const QRectF layerExposed = exposedRect.translated(-offset);
 
         painter.setOpacity(layer->effectiveOpacity());
         painter.translate(offset);
@@ -180,7 +345,10 @@ void MiniMapRenderer::renderToImage(QImage &image, RenderFlags renderFlags) cons
         case Layer::TileLayerType: {
             if (drawTileLayers) {
                 const TileLayer *tileLayer = static_cast<const TileLayer*>(layer);
-                mRenderer->drawTileLayer(&painter, tileLayer);
+                if (drawTileColors)
+                    ::drawTileColors(painter, tileLayer, layerExposed);
+                else
+                    mRenderer->drawTileLayer(&painter, tileLayer, layerExposed);
             }
             break;
         }
@@ -215,7 +383,7 @@ void MiniMapRenderer::renderToImage(QImage &image, RenderFlags renderFlags) cons
         case Layer::ImageLayerType: {
             if (drawImageLayers) {
                 const ImageLayer *imageLayer = static_cast<const ImageLayer*>(layer);
-                mRenderer->drawImageLayer(&painter, imageLayer);
+                mRenderer->drawImageLayer(&painter, imageLayer, layerExposed);
             }
             break;
         }
@@ -228,8 +396,11 @@ void MiniMapRenderer::renderToImage(QImage &image, RenderFlags renderFlags) cons
         painter.translate(-offset);
     }
 
-    if (drawTileGrid)
-        mRenderer->drawGrid(&painter, mapBoundingRect, mGridColor);
+    if (drawTileGrid) {
+        const QRectF gridRect = exposedRect.isNull() ? QRectF(mapBoundingRect)
+                                                     : exposedRect & QRectF(mapBoundingRect);
+        mRenderer->drawGrid(&painter, gridRect, mGridColor);
+    }
 
     if (drawObjects && mRenderObjectLabelCallback) {
         for (const Layer *layer : mMap->objectGroups()) {
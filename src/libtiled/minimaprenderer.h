@@ -33,6 +33,7 @@
 #include "tiled_global.h"
 
 #include <QImage>
+#include <QTransform>
 
 #include <functional>
 #include <memory>
@@ -58,6 +59,7 @@ public:
         SmoothPixmapTransform   = 0x0040,
         IncludeOverhangingTiles = 0x0080,
         IgnoreOffsetsAndImages  = 0x0100,
+        DrawTileColors          = 0x0200,
     };
 
     Q_DECLARE_FLAGS(RenderFlags, RenderFlag)
@@ -72,9 +74,15 @@ public:
 
     QImage render(QSize size, RenderFlags renderFlags) const;
 
+    QTransform imageTransform(QSize imageSize, RenderFlags renderFlags) const;
+
     void renderToImage(QImage &image, RenderFlags renderFlags) const;
+    void renderToImage(QImage &image, RenderFlags renderFlags,
+                       const QRect &exposed) const;
 
 private:
+    QRect mapBoundingRect(RenderFlags renderFlags) const;
+
     const Map *mMap;
     std::unique_ptr<MapRenderer> mRenderer;
 #if QT_VERSION < QT_VERSION_CHECK(5, 14, 0)
@@ -260,7 +260,8 @@ void OrthogonalRenderer::drawGrid(QPainter *painter, const QRectF &rect,
 }
 
 void OrthogonalRenderer::drawTileLayer(const RenderTileCallback &renderTile,
-                                       const QRectF &exposed) const
+                                       const QRectF &exposed,
+                                       const ChunkCulling &culling) const
 {
     const int tileWidth = map()->tileWidth();
     const int tileHeight = map()->tileHeight();
@@ -300,9 +301,17 @@ void OrthogonalRenderer::drawTileLayer(const RenderTileCallback &renderTile,
     endX += incX;
     endY += incY;
 
-    for (int y = startY; y != endY; y += incY)
-        for (int x = startX; x != endX; x += incX)
+    for (int y = startY; y != endY; y += incY) {
+        for (int x = startX; x != endX; x += incX) {
+            // Skip the remainder of the row within an empty chunk
+            if (const int skip = culling.emptyRun(QPoint(x, y), QPoint(incX, 0))) {
+                x += (std::min(skip, (endX - x) / incX) - 1) * incX;
+                continue;
+            }
+
             renderTile(QPoint(x, y), QPointF(x * tileWidth, (y + 1) * tileHeight));
+        }
+    }
 }
 
 void OrthogonalRenderer::drawTileSelection(QPainter *painter,
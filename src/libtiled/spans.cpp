@@ -0,0 +1,91 @@
+/*
+ * spans.cpp
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of libtiled.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice,
+ *       this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "spans.h"
+
+#include <QVector>
+
+#include <algorithm>
+
+namespace Tiled {
+
+/**
+ * Converts the given spans into a region. The spans are sorted and rows with
+ * identical spans are merged into bands, which is the representation used by
+ * QRegion. This avoids the cost of uniting the spans one by one.
+ */
+QRegion regionFromSpans(std::vector<Span> &spans)
+{
+    std::sort(spans.begin(), spans.end());
+
+    QVector<QRect> rects;
+    int bandStart = 0;      // index of the first rect of the previous band
+    int bandBottom = 0;
+
+    size_t i = 0;
+    while (i < spans.size()) {
+        const int y = spans[i].y;
+        const int rowStart = rects.size();
+
+        // Add the spans on this row, joining the ones that touch
+        for (; i < spans.size() && spans[i].y == y; ++i) {
+            const Span &span = spans[i];
+            if (rects.size() > rowStart && rects.last().right() + 1 >= span.left)
+                rects.last().setRight(std::max(rects.last().right(), span.right));
+            else
+                rects.append(QRect(span.left, y, span.right - span.left + 1, 1));
+        }
+
+        // Extend the previous band when this row has the same spans
+        const int rowCount = rects.size() - rowStart;
+        bool sameAsBand = rowStart > 0 && bandBottom == y - 1 &&
+                rowStart - bandStart == rowCount;
+
+        for (int j = 0; sameAsBand && j < rowCount; ++j) {
+            const QRect &a = rects.at(bandStart + j);
+            const QRect &b = rects.at(rowStart + j);
+            sameAsBand = a.left() == b.left() && a.right() == b.right();
+        }
+
+        if (sameAsBand) {
+            rects.resize(rowStart);
+            for (int j = bandStart; j < rowStart; ++j)
+                rects[j].setBottom(y);
+        } else {
+            bandStart = rowStart;
+        }
+
+        bandBottom = y;
+    }
+
+    QRegion region;
+    region.setRects(rects.constData(), rects.size());
+    return region;
+}
+
+} // namespace Tiled
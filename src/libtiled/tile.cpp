@@ -143,6 +143,7 @@ void Tile::setImage(const QPixmap &image)
     mImage = image;
     mImageStatus = image.isNull() ? LoadingError : LoadingReady;
     mImageShape.reset();
+    mAverageColor.reset();
 }
 
 /**
@@ -167,6 +168,54 @@ void Tile::setImageRect(const QRect &imageRect)
 
     mImageRect = imageRect;
     mImageShape.reset();
+    mAverageColor.reset();
+}
+
+/**
+ * Returns the average color of the tile image, as a premultiplied ARGB value.
+ *
+ * The color is computed on first use and remembered until the image or image
+ * rect changes. It can be used to quickly render a very small version of a
+ * map.
+ *
+ * Since the image is a QPixmap, this function may only be called from the
+ * GUI thread.
+ */
+QRgb Tile::averageColor() const
+{
+    if (mAverageColor.has_value())
+        return *mAverageColor;
+
+    const QPixmap &pixmap = image();
+    const QRect rect = mImageRect & pixmap.rect();
+
+    if (rect.isEmpty()) {
+        mAverageColor = 0;
+        return *mAverageColor;
+    }
+
+    const QImage tileImage = pixmap.copy(rect).toImage()
+            .convertToFormat(QImage::Format_ARGB32_Premultiplied);
+
+    quint64 red = 0, green = 0, blue = 0, alpha = 0;
+
+    for (int y = 0; y < tileImage.height(); ++y) {
+        auto line = reinterpret_cast<const QRgb*>(tileImage.constScanLine(y));
+        for (int x = 0; x < tileImage.width(); ++x) {
+            const QRgb pixel = line[x];
+            red += qRed(pixel);
+            green += qGreen(pixel);
+            blue += qBlue(pixel);
+            alpha += qAlpha(pixel);
+        }
+    }
+
+    const quint64 count = static_cast<quint64>(rect.width()) * rect.height();
+    mAverageColor = qRgba(static_cast<int>(red / count),
+                          static_cast<int>(green / count),
+                          static_cast<int>(blue / count),
+                          static_cast<int>(alpha / count));
+    return *mAverageColor;
 }
 
 /**
@@ -265,6 +314,7 @@ Tile *Tile::clone(Tileset *tileset) const
 
     c->mImageSource = mImageSource;
     c->mImageRect = mImageRect;
+    c->mAverageColor = mAverageColor;
     c->mImageStatus = mImageStatus;
     c->mProbability = mProbability;
 
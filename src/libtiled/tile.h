@@ -82,6 +82,8 @@ public:
     const QPainterPath &imageShape() const;
     void setImage(const QPixmap &image);
 
+    QRgb averageColor() const;
+
     const Tile *currentFrameTile() const;
 
     const QUrl &imageSource() const;
@@ -126,6 +128,7 @@ private:
     mutable std::optional<QPainterPath> mImageShape;   // cache
     QUrl mImageSource;
     QRect mImageRect;
+    mutable std::optional<QRgb> mAverageColor;         // cache
     LoadingStatus mImageStatus;
     qreal mProbability;
     std::unique_ptr<ObjectGroup> mObjectGroup;
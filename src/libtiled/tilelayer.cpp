@@ -34,9 +34,12 @@
 #include "tile.h"
 
 #include <algorithm>
+#include <iterator>
 #include <memory>
+#include <vector>
 
 #include <QSet>
+#include <QtConcurrent>
 
 using namespace Tiled;
 
@@ -211,18 +214,99 @@ void Tiled::TileLayer::setCell(int x, int y, const Cell &cell)
 
     Chunk &_chunk = chunk(x, y);
 
+    tilesetChanged(_chunk.cellAt(x & CHUNK_MASK, y & CHUNK_MASK).tileset(),
+                   cell.tileset());
+
+    _chunk.setCell(x & CHUNK_MASK, y & CHUNK_MASK, cell);
+}
+
+/**
+ * Keeps the used tilesets up to date when a cell referring to \a oldTileset
+ * is replaced with one referring to \a newTileset.
+ */
+void TileLayer::tilesetChanged(Tileset *oldTileset, Tileset *newTileset)
+{
+    if (mUsedTilesetsDirty || oldTileset == newTileset)
+        return;
+
+    if (oldTileset)
+        mUsedTilesetsDirty = true;
+    else if (newTileset)
+        mUsedTilesets.insert(newTileset->sharedFromThis());
+}
+
+static bool isModified(const Cell &cell)
+{
+    return cell != Cell::empty || cell.checked();
+}
+
+/**
+ * Replaces the chunk containing the cell at the given coordinates with a copy
+ * of \a source, or with empty cells when \a source is null.
+ *
+ * The copy shares its data with \a source until either is changed.
+ */
+void TileLayer::setChunk(int x, int y, const Chunk *source)
+{
+    const QPoint chunkCoordinates(x >> CHUNK_BITS, y >> CHUNK_BITS);
+    auto it = mChunks.find(chunkCoordinates);
+
+    if (it == mChunks.end()) {
+        // Like setCell, don't create chunks that would only hold empty cells
+        if (!source || !source->hasCell(isModified))
+            return;
+
+        mBounds = mBounds.united(QRect(x - (x & CHUNK_MASK),
+                                       y - (y & CHUNK_MASK),
+                                       CHUNK_SIZE,
+                                       CHUNK_SIZE));
+        it = mChunks.insert(chunkCoordinates, Chunk());
+    }
+
     if (!mUsedTilesetsDirty) {
-        Tileset *oldTileset = _chunk.cellAt(x & CHUNK_MASK, y & CHUNK_MASK).tileset();
-        Tileset *newTileset = cell.tileset();
-        if (oldTileset != newTileset) {
-            if (oldTileset)
-                mUsedTilesetsDirty = true;
-            else if (newTileset)
-                mUsedTilesets.insert(newTileset->sharedFromThis());
+        if (it->hasCell([] (const Cell &cell) { return cell.tileset(); })) {
+            mUsedTilesetsDirty = true;
+        } else if (source) {
+            Tileset *previous = nullptr;
+            for (const Cell &cell : *source) {
+                if (cell.tileset() != previous) {
+                    previous = cell.tileset();
+                    tilesetChanged(nullptr, previous);
+                }
+            }
         }
     }
 
-    _chunk.setCell(x & CHUNK_MASK, y & CHUNK_MASK, cell);
+    *it = source ? *source : Chunk();
+}
+
+/**
+ * Sets \a count cells starting at the given coordinates to the given
+ * \a cells, or to empty cells when \a cells is null. The cells must all be
+ * part of the same chunk.
+ */
+void TileLayer::setRowCells(int x, int y, const Cell *cells, int count)
+{
+    if (!findChunk(x, y)) {
+        if (!cells || std::none_of(cells, cells + count, isModified))
+            return;
+
+        mBounds = mBounds.united(QRect(x - (x & CHUNK_MASK),
+                                       y - (y & CHUNK_MASK),
+                                       CHUNK_SIZE,
+                                       CHUNK_SIZE));
+    }
+
+    Chunk &_chunk = chunk(x, y);
+    const int chunkY = y & CHUNK_MASK;
+
+    for (int i = 0; i < count; ++i) {
+        const int chunkX = (x + i) & CHUNK_MASK;
+        const Cell &cell = cells ? cells[i] : Cell::empty;
+
+        tilesetChanged(_chunk.cellAt(chunkX, chunkY).tileset(), cell.tileset());
+        _chunk.setCell(chunkX, chunkY, cell);
+    }
 }
 
 std::unique_ptr<TileLayer> TileLayer::copy(const QRegion &region) const
@@ -251,12 +335,23 @@ void TileLayer::merge(QPoint pos, const TileLayer *layer)
     QRect area = QRect(pos, QSize(layer->width(), layer->height()));
     area &= QRect(0, 0, width(), height());
 
-    for (int y = area.top(); y <= area.bottom(); ++y) {
-        for (int x = area.left(); x <= area.right(); ++x) {
-            const Cell &cell = layer->cellAt(x - pos.x(),
-                                             y - pos.y());
-            if (!cell.isEmpty())
-                setCell(x, y, cell);
+    // Only the existing chunks of the merged layer can contain tiles
+    QHashIterator<QPoint, Chunk> it(layer->mChunks);
+    while (it.hasNext()) {
+        it.next();
+
+        const QPoint chunkPos(it.key().x() * CHUNK_SIZE + pos.x(),
+                              it.key().y() * CHUNK_SIZE + pos.y());
+        const QRect chunkArea = area & QRect(chunkPos, QSize(CHUNK_SIZE, CHUNK_SIZE));
+        const Chunk &chunk = it.value();
+
+        for (int y = chunkArea.top(); y <= chunkArea.bottom(); ++y) {
+            for (int x = chunkArea.left(); x <= chunkArea.right(); ++x) {
+                const Cell &cell = chunk.cellAt(x - chunkPos.x(),
+                                                y - chunkPos.y());
+                if (!cell.isEmpty())
+                    setCell(x, y, cell);
+            }
         }
     }
 }
@@ -264,10 +359,44 @@ void TileLayer::merge(QPoint pos, const TileLayer *layer)
 void TileLayer::setCells(int x, int y, const TileLayer *layer,
                          const QRegion &area)
 {
-    for (const QRect &rect : area)
-        for (int _x = rect.left(); _x <= rect.right(); ++_x)
-            for (int _y = rect.top(); _y <= rect.bottom(); ++_y)
-                setCell(_x, _y, layer->cellAt(_x - x, _y - y));
+    Q_ASSERT(layer != this);
+
+    // When the offset is chunk-aligned, fully covered chunks are copied whole
+    const bool aligned = (x & CHUNK_MASK) == 0 && (y & CHUNK_MASK) == 0;
+
+    for (const QRect &rect : area) {
+        for (int chunkY = rect.top() >> CHUNK_BITS; chunkY <= rect.bottom() >> CHUNK_BITS; ++chunkY) {
+            for (int chunkX = rect.left() >> CHUNK_BITS; chunkX <= rect.right() >> CHUNK_BITS; ++chunkX) {
+                const QRect chunkRect(chunkX * CHUNK_SIZE, chunkY * CHUNK_SIZE,
+                                      CHUNK_SIZE, CHUNK_SIZE);
+                const QRect part = rect & chunkRect;
+
+                if (aligned && part == chunkRect) {
+                    setChunk(part.left(), part.top(),
+                             layer->findChunk(part.left() - x, part.top() - y));
+                    continue;
+                }
+
+                // Otherwise each row is copied from at most two source chunks
+                for (int _y = part.top(); _y <= part.bottom(); ++_y) {
+                    const int sourceY = _y - y;
+
+                    for (int _x = part.left(); _x <= part.right();) {
+                        const int sourceX = _x - x;
+                        const int count = std::min(part.right() - _x + 1,
+                                                   CHUNK_SIZE - (sourceX & CHUNK_MASK));
+
+                        const Chunk *source = layer->findChunk(sourceX, sourceY);
+                        setRowCells(_x, _y,
+                                    source ? &source->cellAt(sourceX & CHUNK_MASK, sourceY & CHUNK_MASK)
+                                           : nullptr,
+                                    count);
+                        _x += count;
+                    }
+                }
+            }
+        }
+    }
 }
 
 /**
@@ -310,45 +439,147 @@ void TileLayer::clear()
     mUsedTilesetsDirty = false;
 }
 
-void TileLayer::flip(FlipDirection direction)
+namespace {
+
+/**
+ * A chunk of a layer being built by gatherChunks.
+ */
+struct TargetChunk
 {
-    const auto newLayer = std::make_unique<TileLayer>(QString(), 0, 0, mWidth, mHeight);
+    explicit TargetChunk(QPoint coordinates, bool keep = false)
+        : coordinates(coordinates)
+        , keep(keep)
+    {}
 
-    Q_ASSERT(direction == FlipHorizontally || direction == FlipVertically);
+    QPoint coordinates;
+    Chunk chunk;
+    bool keep;              // whether the chunk is part of the result
+    bool filled = false;    // whether the chunk was already filled
+};
+
+/**
+ * Adds the coordinates of the chunks overlapping \a area to \a coordinates.
+ */
+void addChunksOverlapping(QSet<QPoint> &coordinates, const QRect &area)
+{
+    if (area.isEmpty())
+        return;
+
+    for (int y = area.top() >> CHUNK_BITS; y <= area.bottom() >> CHUNK_BITS; ++y)
+        for (int x = area.left() >> CHUNK_BITS; x <= area.right() >> CHUNK_BITS; ++x)
+            coordinates.insert(QPoint(x, y));
+}
+
+QRect chunkRect(QPoint coordinates)
+{
+    return QRect(coordinates.x() * CHUNK_SIZE, coordinates.y() * CHUNK_SIZE,
+                 CHUNK_SIZE, CHUNK_SIZE);
+}
+
+std::vector<TargetChunk> targetChunks(const QSet<QPoint> &coordinates)
+{
+    std::vector<TargetChunk> targets;
+    targets.reserve(coordinates.size());
+    for (const QPoint &chunkCoordinates : coordinates)
+        targets.emplace_back(chunkCoordinates);
+    return targets;
+}
+
+/**
+ * Fills the \a targets with cells looked up in \a sourceChunks.
+ *
+ * For each cell in a target chunk, \a sourcePos determines the position of the
+ * source cell, or returns false when the cell stays empty. The source cell is
+ * passed through \a transformCell before it is stored.
+ *
+ * Since each target chunk is only written by a single task, the chunks are
+ * filled in parallel.
+ */
+template<typename SourcePos, typename TransformCell>
+void gatherChunks(const QHash<QPoint, Chunk> &sourceChunks,
+                  std::vector<TargetChunk> &targets,
+                  const SourcePos &sourcePos,
+                  const TransformCell &transformCell)
+{
+    QtConcurrent::blockingMap(targets, [&] (TargetChunk &target) {
+        if (target.filled)
+            return;
+
+        const int left = target.coordinates.x() * CHUNK_SIZE;
+        const int top = target.coordinates.y() * CHUNK_SIZE;
+
+        // Source cells tend to come from the same chunk as the previous cell
+        QPoint sourceChunkCoordinates;
+        const Chunk *sourceChunk = nullptr;
+        bool sourceChunkValid = false;
+
+        // Write directly to the cells, which detaches the chunk only once
+        Cell *cells = &*target.chunk.begin();
 
-    QHashIterator<QPoint, Chunk> it(mChunks);
-    while (it.hasNext()) {
-        it.next();
         for (int y = 0; y < CHUNK_SIZE; ++y) {
             for (int x = 0; x < CHUNK_SIZE; ++x) {
-                int _x = it.key().x() * CHUNK_SIZE + x;
-                int _y = it.key().y() * CHUNK_SIZE + y;
+                QPoint source;
+                if (!sourcePos(left + x, top + y, source))
+                    continue;
 
-                Cell dest(it.value().cellAt(x, y));
+                const QPoint coordinates(source.x() >> CHUNK_BITS, source.y() >> CHUNK_BITS);
+                if (!sourceChunkValid || coordinates != sourceChunkCoordinates) {
+                    const auto it = sourceChunks.constFind(coordinates);
+                    sourceChunk = it != sourceChunks.constEnd() ? &it.value() : nullptr;
+                    sourceChunkCoordinates = coordinates;
+                    sourceChunkValid = true;
+                }
 
-                if (dest.isEmpty())
+                if (!sourceChunk)
                     continue;
 
-                if (direction == FlipHorizontally) {
-                    dest.setFlippedHorizontally(!dest.flippedHorizontally());
-                    newLayer->setCell(mWidth - _x - 1, _y, dest);
-                } else if (direction == FlipVertically) {
-                    dest.setFlippedVertically(!dest.flippedVertically());
-                    newLayer->setCell(_x, mHeight - _y - 1, dest);
+                const Cell cell = transformCell(sourceChunk->cellAt(source.x() & CHUNK_MASK,
+                                                                    source.y() & CHUNK_MASK));
+                if (isModified(cell)) {
+                    cells[x + y * CHUNK_SIZE] = cell;
+                    target.keep = true;
                 }
             }
         }
-    }
+    });
+}
 
-    mChunks = newLayer->mChunks;
-    mBounds = newLayer->mBounds;
+/**
+ * Replaces \a chunks with the kept \a targets, updating \a bounds to match.
+ */
+void takeChunks(std::vector<TargetChunk> &targets,
+                QHash<QPoint, Chunk> &chunks,
+                QRect &bounds)
+{
+    chunks.clear();
+    bounds = QRect();
+
+    for (TargetChunk &target : targets) {
+        if (!target.keep)
+            continue;
+
+        bounds |= chunkRect(target.coordinates);
+        chunks.insert(target.coordinates, std::move(target.chunk));
+    }
 }
 
-void TileLayer::flipHexagonal(FlipDirection direction)
+Cell flipped(const Cell &cell, FlipDirection direction)
 {
-    const auto newLayer = std::make_unique<TileLayer>(QString(), 0, 0, mWidth, mHeight);
+    if (cell.isEmpty())
+        return Cell();
+
+    Cell dest(cell);
+    if (direction == FlipHorizontally)
+        dest.setFlippedHorizontally(!dest.flippedHorizontally());
+    else
+        dest.setFlippedVertically(!dest.flippedVertically());
+    return dest;
+}
 
-    Q_ASSERT(direction == FlipHorizontally || direction == FlipVertically);
+Cell flippedHexagonal(const Cell &cell, FlipDirection direction)
+{
+    if (cell.isEmpty())
+        return Cell();
 
     // for more info see impl "void TileLayer::rotateHexagonal(RotateDirection direction)"
     static constexpr unsigned char flipMaskH[16] = { 8, 6, 5, 4, 12, 2, 1, 0, 0, 14, 13, 12, 4, 10, 9, 8 }; // [0,15]<=>[8,7]; 2<=>5; 1<=>6; [12,3]<=>[4,11]; 14<=>9; 13<=>10;
@@ -356,42 +587,68 @@ void TileLayer::flipHexagonal(FlipDirection direction)
 
     const unsigned char (&flipMask)[16] = (direction == FlipHorizontally ? flipMaskH : flipMaskV);
 
-    QHashIterator<QPoint, Chunk> it(mChunks);
-    while (it.hasNext()) {
-        it.next();
-        for (int y = 0; y < CHUNK_SIZE; ++y) {
-            for (int x = 0; x < CHUNK_SIZE; ++x) {
-                int _x = it.key().x() * CHUNK_SIZE + x;
-                int _y = it.key().y() * CHUNK_SIZE + y;
+    Cell dest(cell);
 
-                Cell dest(it.value().cellAt(x, y));
-
-                if (dest.isEmpty())
-                    continue;
+    unsigned char mask =
+            (static_cast<unsigned char>(dest.flippedHorizontally()) << 3) |
+            (static_cast<unsigned char>(dest.flippedVertically()) << 2) |
+            (static_cast<unsigned char>(dest.flippedAntiDiagonally()) << 1) |
+            (static_cast<unsigned char>(dest.rotatedHexagonal120()) << 0);
+
+    mask = flipMask[mask];
+
+    dest.setFlippedHorizontally((mask & 8) != 0);
+    dest.setFlippedVertically((mask & 4) != 0);
+    dest.setFlippedAntiDiagonally((mask & 2) != 0);
+    dest.setRotatedHexagonal120((mask & 1) != 0);
+    return dest;
+}
 
-                unsigned char mask =
-                        (static_cast<unsigned char>(dest.flippedHorizontally()) << 3) |
-                        (static_cast<unsigned char>(dest.flippedVertically()) << 2) |
-                        (static_cast<unsigned char>(dest.flippedAntiDiagonally()) << 1) |
-                        (static_cast<unsigned char>(dest.rotatedHexagonal120()) << 0);
+} // anonymous namespace
 
-                mask = flipMask[mask];
+/**
+ * Moves the cells of this layer according to \a direction, with \a flipCell
+ * used to change the flags of each cell.
+ */
+template<typename FlipCell>
+static void flipChunks(QHash<QPoint, Chunk> &chunks, QRect &bounds,
+                       FlipDirection direction, QSize size,
+                       const FlipCell &flipCell)
+{
+    Q_ASSERT(direction == FlipHorizontally || direction == FlipVertically);
 
-                dest.setFlippedHorizontally((mask & 8) != 0);
-                dest.setFlippedVertically((mask & 4) != 0);
-                dest.setFlippedAntiDiagonally((mask & 2) != 0);
-                dest.setRotatedHexagonal120((mask & 1) != 0);
+    // Flipping maps each position onto itself when applied twice
+    const auto flipPos = [=] (int x, int y) {
+        return direction == FlipHorizontally ? QPoint(size.width() - x - 1, y)
+                                             : QPoint(x, size.height() - y - 1);
+    };
 
-                if (direction == FlipHorizontally)
-                    newLayer->setCell(mWidth - _x - 1, _y, dest);
-                else
-                    newLayer->setCell(_x, mHeight - _y - 1, dest);
-            }
-        }
+    QSet<QPoint> coordinates;
+    for (auto it = chunks.cbegin(); it != chunks.cend(); ++it) {
+        const QRect rect = chunkRect(it.key());
+        addChunksOverlapping(coordinates, QRect(flipPos(rect.left(), rect.top()),
+                                                flipPos(rect.right(), rect.bottom())).normalized());
     }
 
-    mChunks = newLayer->mChunks;
-    mBounds = newLayer->mBounds;
+    const auto sourcePos = [&] (int x, int y, QPoint &source) {
+        source = flipPos(x, y);
+        return true;
+    };
+
+    auto targets = targetChunks(coordinates);
+    gatherChunks(chunks, targets, sourcePos,
+                 [&] (const Cell &cell) { return flipCell(cell, direction); });
+    takeChunks(targets, chunks, bounds);
+}
+
+void TileLayer::flip(FlipDirection direction)
+{
+    flipChunks(mChunks, mBounds, direction, size(), flipped);
+}
+
+void TileLayer::flipHexagonal(FlipDirection direction)
+{
+    flipChunks(mChunks, mBounds, direction, size(), flippedHexagonal);
 }
 
 void TileLayer::rotate(RotateDirection direction)
@@ -402,46 +659,53 @@ void TileLayer::rotate(RotateDirection direction)
     const unsigned char (&rotateMask)[8] =
             (direction == RotateRight) ? rotateRightMask : rotateLeftMask;
 
-    int newWidth = mHeight;
-    int newHeight = mWidth;
-    const auto newLayer = std::make_unique<TileLayer>(QString(), 0, 0, newWidth, newHeight);
+    const int width = mWidth;
+    const int height = mHeight;
 
-    QHashIterator<QPoint, Chunk> it(mChunks);
-    while (it.hasNext()) {
-        it.next();
-        for (int y = 0; y < CHUNK_SIZE; ++y) {
-            for (int x = 0; x < CHUNK_SIZE; ++x) {
-                int _x = it.key().x() * CHUNK_SIZE + x;
-                int _y = it.key().y() * CHUNK_SIZE + y;
+    const auto rotatePos = [=] (int x, int y) {
+        return direction == RotateRight ? QPoint(height - y - 1, x)
+                                        : QPoint(y, width - x - 1);
+    };
 
-                Cell dest(it.value().cellAt(x, y));
+    QSet<QPoint> coordinates;
+    for (auto it = mChunks.cbegin(); it != mChunks.cend(); ++it) {
+        const QRect rect = chunkRect(it.key());
+        addChunksOverlapping(coordinates, QRect(rotatePos(rect.left(), rect.top()),
+                                                rotatePos(rect.right(), rect.bottom())).normalized());
+    }
 
-                if (dest.isEmpty())
-                    continue;
+    // Inverse of rotatePos
+    const auto sourcePos = [=] (int x, int y, QPoint &source) {
+        source = direction == RotateRight ? QPoint(y, height - x - 1)
+                                          : QPoint(width - y - 1, x);
+        return true;
+    };
 
-                unsigned char mask =
-                        (dest.flippedHorizontally() << 2) |
-                        (dest.flippedVertically() << 1) |
-                        (dest.flippedAntiDiagonally() << 0);
+    const auto rotateCell = [&] (const Cell &cell) {
+        if (cell.isEmpty())
+            return Cell();
 
-                mask = rotateMask[mask];
+        Cell dest(cell);
 
-                dest.setFlippedHorizontally((mask & 4) != 0);
-                dest.setFlippedVertically((mask & 2) != 0);
-                dest.setFlippedAntiDiagonally((mask & 1) != 0);
+        unsigned char mask =
+                (dest.flippedHorizontally() << 2) |
+                (dest.flippedVertically() << 1) |
+                (dest.flippedAntiDiagonally() << 0);
 
-                if (direction == RotateRight)
-                    newLayer->setCell(mHeight - _y - 1, _x, dest);
-                else
-                    newLayer->setCell(_y, mWidth - _x - 1, dest);
-            }
-        }
-    }
+        mask = rotateMask[mask];
 
-    mWidth = newWidth;
-    mHeight = newHeight;
-    mChunks = newLayer->mChunks;
-    mBounds = newLayer->mBounds;
+        dest.setFlippedHorizontally((mask & 4) != 0);
+        dest.setFlippedVertically((mask & 2) != 0);
+        dest.setFlippedAntiDiagonally((mask & 1) != 0);
+        return dest;
+    };
+
+    auto targets = targetChunks(coordinates);
+    gatherChunks(mChunks, targets, sourcePos, rotateCell);
+
+    mWidth = height;
+    mHeight = width;
+    takeChunks(targets, mChunks, mBounds);
 }
 
 void TileLayer::rotateHexagonal(RotateDirection direction, Map *map)
@@ -489,15 +753,30 @@ void TileLayer::rotateHexagonal(RotateDirection direction, Map *map)
     const unsigned char (&rotateMask)[16] =
             (direction == RotateRight) ? rotateRightMask : rotateLeftMask;
 
-    QHashIterator<QPoint, Chunk> it(mChunks);
-    while (it.hasNext()) {
-        it.next();
+    // Rotate the cells of each chunk in parallel, collecting them to be set
+    // on the new layer afterwards, since their positions are not aligned.
+    struct RotatedCell { QPoint pos; Cell cell; };
+    struct RotatedChunk {
+        QPoint coordinates;
+        const Chunk *chunk;
+        std::vector<RotatedCell> cells;
+    };
+
+    std::vector<RotatedChunk> rotatedChunks;
+    rotatedChunks.reserve(mChunks.size());
+    for (auto it = mChunks.cbegin(); it != mChunks.cend(); ++it)
+        rotatedChunks.push_back({ it.key(), &it.value(), {} });
+
+    QtConcurrent::blockingMap(rotatedChunks, [&] (RotatedChunk &rotatedChunk) {
+        const QPoint coordinates = rotatedChunk.coordinates;
+        const Chunk &chunk = *rotatedChunk.chunk;
+
         for (int y = 0; y < CHUNK_SIZE; ++y) {
             for (int x = 0; x < CHUNK_SIZE; ++x) {
-                int _x = it.key().x() * CHUNK_SIZE + x;
-                int _y = it.key().y() * CHUNK_SIZE + y;
+                int _x = coordinates.x() * CHUNK_SIZE + x;
+                int _y = coordinates.y() * CHUNK_SIZE + y;
 
-                Cell dest(it.value().cellAt(x, y));
+                Cell dest(chunk.cellAt(x, y));
 
                 if (dest.isEmpty())
                     continue;
@@ -520,12 +799,14 @@ void TileLayer::rotateHexagonal(RotateDirection direction, Map *map)
                 rotatedHex.rotate(direction);
                 rotatedHex += newCenter;
 
-                QPoint rotatedPoint = rotatedHex.toStaggered(staggerIndex, staggerAxis);
-
-                newLayer->setCell(rotatedPoint.x(), rotatedPoint.y(), dest);
+                rotatedChunk.cells.push_back({ rotatedHex.toStaggered(staggerIndex, staggerAxis), dest });
             }
         }
-    }
+    });
+
+    for (const RotatedChunk &rotatedChunk : rotatedChunks)
+        for (const RotatedCell &rotatedCell : rotatedChunk.cells)
+            newLayer->setCell(rotatedCell.pos.x(), rotatedCell.pos.y(), rotatedCell.cell);
 
     mWidth = newWidth;
     mHeight = newHeight;
@@ -602,16 +883,43 @@ void TileLayer::resize(QSize size, QPoint offset)
     if (this->size() == size && offset.isNull())
         return;
 
-    const auto newLayer = std::make_unique<TileLayer>(QString(), 0, 0, size.width(), size.height());
-
     // Copy over the preserved part
-    QRect area = mBounds.translated(offset).intersected(newLayer->rect());
-    for (int y = area.top(); y <= area.bottom(); ++y)
-        for (int x = area.left(); x <= area.right(); ++x)
-            newLayer->setCell(x, y, cellAt(x - offset.x(), y - offset.y()));
+    const QRect newRect(QPoint(), size);
+    const QRect area = mBounds.translated(offset).intersected(newRect);
+    const bool aligned = (offset.x() & CHUNK_MASK) == 0 && (offset.y() & CHUNK_MASK) == 0;
+    const QPoint chunkOffset(offset.x() >> CHUNK_BITS, offset.y() >> CHUNK_BITS);
+
+    QSet<QPoint> coordinates;
+    std::vector<TargetChunk> movedChunks;
+
+    for (auto it = mChunks.cbegin(); it != mChunks.cend(); ++it) {
+        const QRect rect = chunkRect(it.key()).translated(offset).intersected(area);
+
+        // With a chunk-aligned offset, chunks that remain entirely within
+        // the layer are moved as a whole
+        if (aligned && rect.size() == QSize(CHUNK_SIZE, CHUNK_SIZE)) {
+            if (it.value().hasCell(isModified)) {
+                TargetChunk &target = movedChunks.emplace_back(it.key() + chunkOffset, true);
+                target.chunk = it.value();
+                target.filled = true;
+            }
+        } else {
+            addChunksOverlapping(coordinates, rect);
+        }
+    }
 
-    mChunks = newLayer->mChunks;
-    mBounds = newLayer->mBounds;
+    const auto sourcePos = [&] (int x, int y, QPoint &source) {
+        if (!area.contains(x, y))
+            return false;
+        source = QPoint(x, y) - offset;
+        return true;
+    };
+
+    auto targets = targetChunks(coordinates);
+    gatherChunks(mChunks, targets, sourcePos, [] (const Cell &cell) { return cell; });
+
+    std::move(movedChunks.begin(), movedChunks.end(), std::back_inserter(targets));
+    takeChunks(targets, mChunks, mBounds);
     setSize(size);
 }
 
@@ -629,60 +937,86 @@ void TileLayer::offsetTiles(QPoint offset,
     if (offset.isNull())
         return;
 
-    const std::unique_ptr<TileLayer> newLayer(clone());
+    // Chunks that don't overlap the bounds are left as they are, while the
+    // others are filled again. Existing chunks are kept even when they end
+    // up empty, as when their cells are erased.
+    QSet<QPoint> coordinates;
+    addChunksOverlapping(coordinates, bounds);
 
-    for (int y = bounds.top(); y <= bounds.bottom(); ++y) {
-        for (int x = bounds.left(); x <= bounds.right(); ++x) {
-            // Get position to pull tile value from
-            int oldX = x - offset.x();
-            int oldY = y - offset.y();
+    std::vector<TargetChunk> targets;
+    targets.reserve(mChunks.size() + coordinates.size());
 
-            // Wrap x value that will be pulled from
-            if (wrapX)
-                oldX = clampWrap(oldX, bounds.left(), bounds.right() + 1);
+    for (auto it = mChunks.cbegin(); it != mChunks.cend(); ++it) {
+        TargetChunk &target = targets.emplace_back(it.key(), true);
+        if (!coordinates.remove(it.key())) {
+            target.chunk = it.value();
+            target.filled = true;
+        }
+    }
 
-            // Wrap y value that will be pulled from
-            if (wrapY)
-                oldY = clampWrap(oldY, bounds.top(), bounds.bottom() + 1);
+    for (const QPoint &chunkCoordinates : std::as_const(coordinates))
+        targets.emplace_back(chunkCoordinates);
 
-            // Set the new tile
-            if (bounds.contains(oldX, oldY))
-                newLayer->setCell(x, y, cellAt(oldX, oldY));
-            else
-                newLayer->setCell(x, y, Cell::empty);
+    const auto sourcePos = [&] (int x, int y, QPoint &source) {
+        if (!bounds.contains(x, y)) {
+            source = QPoint(x, y);
+            return true;
         }
-    }
 
-    mChunks = newLayer->mChunks;
-    mBounds = newLayer->mBounds;
+        // Get position to pull tile value from
+        int oldX = x - offset.x();
+        int oldY = y - offset.y();
+
+        // Wrap x value that will be pulled from
+        if (wrapX)
+            oldX = clampWrap(oldX, bounds.left(), bounds.right() + 1);
+
+        // Wrap y value that will be pulled from
+        if (wrapY)
+            oldY = clampWrap(oldY, bounds.top(), bounds.bottom() + 1);
+
+        source = QPoint(oldX, oldY);
+        return bounds.contains(source);
+    };
+
+    gatherChunks(mChunks, targets, sourcePos, [] (const Cell &cell) { return cell; });
+    takeChunks(targets, mChunks, mBounds);
 }
 
 void TileLayer::offsetTiles(QPoint offset)
 {
-    const auto newLayer = std::make_unique<TileLayer>(QString(), 0, 0, 0, 0);
+    const bool aligned = (offset.x() & CHUNK_MASK) == 0 && (offset.y() & CHUNK_MASK) == 0;
+    const QPoint chunkOffset(offset.x() >> CHUNK_BITS, offset.y() >> CHUNK_BITS);
 
     // Process only the allocated chunks
-    QHashIterator<QPoint, Chunk> it(mChunks);
-    while (it.hasNext()) {
-        it.next();
-
-        const QPoint p = it.key();
-        const Chunk &chunk = it.value();
-        const QRect r(p.x() * CHUNK_SIZE,
-                      p.y() * CHUNK_SIZE,
-                      CHUNK_SIZE, CHUNK_SIZE);
-
-        for (int y = r.top(); y <= r.bottom(); ++y) {
-            for (int x = r.left(); x <= r.right(); ++x) {
-                int newX = x + offset.x();
-                int newY = y + offset.y();
-                newLayer->setCell(newX, newY, chunk.cellAt(x - r.left(), y - r.top()));
+    QSet<QPoint> coordinates;
+    std::vector<TargetChunk> movedChunks;
+
+    for (auto it = mChunks.cbegin(); it != mChunks.cend(); ++it) {
+        const QRect rect = chunkRect(it.key()).translated(offset);
+
+        // With a chunk-aligned offset, the chunks are moved as a whole
+        if (aligned) {
+            if (it.value().hasCell(isModified)) {
+                TargetChunk &target = movedChunks.emplace_back(it.key() + chunkOffset, true);
+                target.chunk = it.value();
+                target.filled = true;
             }
+        } else {
+            addChunksOverlapping(coordinates, rect);
         }
     }
 
-    mChunks = newLayer->mChunks;
-    mBounds = newLayer->mBounds;
+    const auto sourcePos = [&] (int x, int y, QPoint &source) {
+        source = QPoint(x, y) - offset;
+        return true;
+    };
+
+    auto targets = targetChunks(coordinates);
+    gatherChunks(mChunks, targets, sourcePos, [] (const Cell &cell) { return cell; });
+
+    std::move(movedChunks.begin(), movedChunks.end(), std::back_inserter(targets));
+    takeChunks(targets, mChunks, mBounds);
 }
 
 bool TileLayer::canMergeWith(const Layer *other) const
@@ -713,24 +1047,30 @@ Layer *TileLayer::mergedWith(const Layer *other) const
 }
 
 QRegion TileLayer::computeDiffRegion(const TileLayer &other) const
+{
+    const QRect r = bounds().united(other.bounds()).translated(-position());
+    return computeDiffRegion(other, r);
+}
+
+QRegion TileLayer::computeDiffRegion(const TileLayer &other, const QRegion &region) const
 {
     QRegion ret;
 
     const int dx = other.x() - mX;
     const int dy = other.y() - mY;
 
-    const QRect r = bounds().united(other.bounds()).translated(-position());
-
-    for (int y = r.top(); y <= r.bottom(); ++y) {
-        for (int x = r.left(); x <= r.right(); ++x) {
-            if (cellAt(x, y) != other.cellAt(x - dx, y - dy)) {
-                const int rangeStart = x;
-                while (x <= r.right() &&
-                       cellAt(x, y) != other.cellAt(x - dx, y - dy)) {
-                    ++x;
+    for (const QRect &r : region) {
+        for (int y = r.top(); y <= r.bottom(); ++y) {
+            for (int x = r.left(); x <= r.right(); ++x) {
+                if (cellAt(x, y) != other.cellAt(x - dx, y - dy)) {
+                    const int rangeStart = x;
+                    while (x <= r.right() &&
+                           cellAt(x, y) != other.cellAt(x - dx, y - dy)) {
+                        ++x;
+                    }
+                    const int rangeEnd = x;
+                    ret += QRect(rangeStart, y, rangeEnd - rangeStart, 1);
                 }
-                const int rangeEnd = x;
-                ret += QRect(rangeStart, y, rangeEnd - rangeStart, 1);
             }
         }
     }
@@ -387,6 +387,8 @@ public:
 
     void setCell(int x, int y, const Cell &cell);
 
+    void setChunk(int x, int y, const Chunk *source);
+
     /**
      * Returns a copy of the area specified by the given \a region. The
      * caller is responsible for the returned tile layer.
@@ -514,11 +516,23 @@ public:
      */
     QRegion computeDiffRegion(const TileLayer &other) const;
 
+    /**
+     * Returns the region where this tile layer and the \a other tile layer
+     * are different, only comparing the cells within \a region. Both the
+     * given and the returned region are relative to this tile layer.
+     */
+    QRegion computeDiffRegion(const TileLayer &other, const QRegion &region) const;
+
     /**
      * Returns true if all tiles in the layer are empty.
      */
     bool isEmpty() const override;
 
+    /**
+     * Returns the number of chunks allocated by this layer.
+     */
+    int chunkCount() const { return mChunks.size(); }
+
     TileLayer *clone() const override;
 
     iterator begin() { return iterator(mChunks.begin(), mChunks.end()); }
@@ -532,6 +546,9 @@ protected:
     TileLayer *initializeClone(TileLayer *clone) const;
 
 private:
+    void setRowCells(int x, int y, const Cell *cells, int count);
+    void tilesetChanged(Tileset *oldTileset, Tileset *newTileset);
+
     int mWidth;
     int mHeight;
     QHash<QPoint, Chunk> mChunks;
@@ -0,0 +1,280 @@
+/*
+ * tintedpixmapcache.cpp
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of libtiled.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice,
+ *       this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "tintedpixmapcache.h"
+
+#include <QCache>
+#include <QHash>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QPainter>
+
+#include <limits>
+
+namespace Tiled {
+
+struct TintedKey
+{
+    const qint64 key;
+    const QColor color;
+
+    bool operator==(const TintedKey &o) const
+    {
+        return key == o.key && color == o.color;
+    }
+};
+
+#if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
+static uint qHash(const TintedKey &key, uint seed) Q_DECL_NOTHROW
+#else
+static size_t qHash(const TintedKey &key, size_t seed) Q_DECL_NOTHROW
+#endif
+{
+    auto h = ::qHash(key.key, seed);
+    h = ::qHash(key.color.rgba(), h);
+    return h;
+}
+
+// Borrowed from qpixmapcache.cpp
+static inline qsizetype cost(const QPixmap &pixmap)
+{
+    // make sure to do a 64bit calculation; qsizetype might be smaller
+    const qint64 costKb = static_cast<qint64>(pixmap.width())
+                        * pixmap.height() * pixmap.depth() / (8 * 1024);
+    const qint64 costMax = std::numeric_limits<qsizetype>::max();
+    // a small pixmap should have at least a cost of 1(kb)
+    return static_cast<qsizetype>(qBound(1LL, costKb, costMax));
+}
+
+static QPixmap tint(const QPixmap &pixmap, const QColor &color)
+{
+    QPixmap resultImage = pixmap;
+    QPainter painter(&resultImage);
+
+    QColor fullOpacity = color;
+    fullOpacity.setAlpha(255);
+    // tint the final color (this will will mess up the alpha which we will fix
+    // in the next lines)
+    painter.setCompositionMode(QPainter::CompositionMode_Multiply);
+    painter.fillRect(resultImage.rect(), fullOpacity);
+
+    // apply the original alpha to the final image
+    painter.setCompositionMode(QPainter::CompositionMode_DestinationIn);
+    painter.drawPixmap(0, 0, pixmap);
+
+    // apply the alpha of the tint color so that we can use it to make the image
+    // transparent instead of just increasing or decreasing the tint effect
+    painter.setCompositionMode(QPainter::CompositionMode_DestinationIn);
+    painter.fillRect(resultImage.rect(), color);
+
+    painter.end();
+
+    return resultImage;
+}
+
+namespace {
+
+struct CacheData
+{
+    QMutex mutex;
+    QCache<TintedKey, QPixmap> cache { 100 * 1024 };   // in kilobytes
+    QHash<TintedKey, QPixmap> pinned;                   // not limited in size
+    QHash<QRgb, int> pinnedColors;                      // reference counts
+    qint64 pinnedCost = 0;
+    TintedPixmapCache::Statistics statistics;
+
+    bool isPinned(const QColor &color) const
+    {
+        return pinnedColors.contains(color.rgba());
+    }
+
+    void pin(const TintedKey &key, const QPixmap &pixmap)
+    {
+        pinned.insert(key, pixmap);
+        pinnedCost += cost(pixmap);
+    }
+};
+
+} // anonymous namespace
+
+static CacheData &cacheData()
+{
+    static CacheData data;
+    return data;
+}
+
+/**
+ * Returns the given \a pixmap tinted with \a color. Returns the pixmap
+ * itself when the color is invalid or white.
+ *
+ * Since tileset images are shared by all their tiles, a tinted atlas is
+ * created only once per tint color.
+ */
+QPixmap TintedPixmapCache::tinted(const QPixmap &pixmap, const QColor &color)
+{
+    if (!color.isValid() || color == QColor(255, 255, 255, 255) || pixmap.isNull())
+        return pixmap;
+
+    auto &data = cacheData();
+    QMutexLocker locker(&data.mutex);
+
+    const TintedKey tintedKey { pixmap.cacheKey(), color };
+
+    const auto pinnedIt = data.pinned.constFind(tintedKey);
+    if (pinnedIt != data.pinned.constEnd()) {
+        ++data.statistics.hits;
+        return pinnedIt.value();
+    }
+
+    const bool pinned = data.isPinned(color);
+
+    if (auto cached = data.cache.object(tintedKey)) {
+        ++data.statistics.hits;
+
+        const QPixmap result = *cached;
+        if (pinned) {
+            data.cache.remove(tintedKey);
+            data.pin(tintedKey, result);
+        }
+        return result;
+    }
+
+    ++data.statistics.misses;
+
+    const QPixmap result = tint(pixmap, color);
+    if (pinned)
+        data.pin(tintedKey, result);
+    else
+        data.cache.insert(tintedKey, new QPixmap(result), cost(result));
+
+    return result;
+}
+
+/**
+ * Keeps the pixmaps tinted with \a color until the color is unpinned as many
+ * times as it was pinned. Used for the tint colors of visible layers, which
+ * would otherwise be tinted again when evicted while panning.
+ */
+void TintedPixmapCache::pinColor(const QColor &color)
+{
+    if (!color.isValid() || color == QColor(255, 255, 255, 255))
+        return;
+
+    auto &data = cacheData();
+    QMutexLocker locker(&data.mutex);
+    ++data.pinnedColors[color.rgba()];
+}
+
+/**
+ * Releases a pin on \a color. When the color is no longer pinned, its
+ * pixmaps are moved back to the size-limited part of the cache.
+ */
+void TintedPixmapCache::unpinColor(const QColor &color)
+{
+    if (!color.isValid() || color == QColor(255, 255, 255, 255))
+        return;
+
+    auto &data = cacheData();
+    QMutexLocker locker(&data.mutex);
+
+    const auto it = data.pinnedColors.find(color.rgba());
+    if (it == data.pinnedColors.end() || --it.value() > 0)
+        return;
+
+    data.pinnedColors.erase(it);
+
+    for (auto pinnedIt = data.pinned.begin(); pinnedIt != data.pinned.end(); ) {
+        if (pinnedIt.key().color.rgba() == color.rgba()) {
+            const QPixmap &pixmap = pinnedIt.value();
+            data.pinnedCost -= cost(pixmap);
+            data.cache.insert(pinnedIt.key(), new QPixmap(pixmap), cost(pixmap));
+            pinnedIt = data.pinned.erase(pinnedIt);
+        } else {
+            ++pinnedIt;
+        }
+    }
+}
+
+/**
+ * Returns the maximum size of the cache in megabytes.
+ */
+int TintedPixmapCache::maxSize()
+{
+    auto &data = cacheData();
+    QMutexLocker locker(&data.mutex);
+    return static_cast<int>(data.cache.maxCost() / 1024);
+}
+
+/**
+ * Sets the maximum size of the cache in megabytes. Least recently used
+ * pixmaps are evicted when the cache becomes too large, except for those
+ * tinted with a pinned color.
+ *
+ * The size should be large enough to hold each tinted tileset image in use,
+ * otherwise the images are tinted again each time they are drawn.
+ */
+void TintedPixmapCache::setMaxSize(int megabytes)
+{
+    auto &data = cacheData();
+    QMutexLocker locker(&data.mutex);
+    data.cache.setMaxCost(static_cast<qsizetype>(qMax(1, megabytes)) * 1024);
+}
+
+/**
+ * Returns the hit and miss counters as well as the current usage of the
+ * cache, for diagnostic purposes.
+ */
+TintedPixmapCache::Statistics TintedPixmapCache::statistics()
+{
+    auto &data = cacheData();
+    QMutexLocker locker(&data.mutex);
+
+    Statistics statistics = data.statistics;
+    statistics.usedKilobytes = data.cache.totalCost() + data.pinnedCost;
+    statistics.pinnedKilobytes = data.pinnedCost;
+    statistics.pixmapCount = static_cast<int>(data.cache.count() + data.pinned.size());
+    return statistics;
+}
+
+void TintedPixmapCache::resetStatistics()
+{
+    auto &data = cacheData();
+    QMutexLocker locker(&data.mutex);
+    data.statistics = Statistics();
+}
+
+void TintedPixmapCache::clear()
+{
+    auto &data = cacheData();
+    QMutexLocker locker(&data.mutex);
+    data.cache.clear();
+    data.pinned.clear();
+    data.pinnedCost = 0;
+}
+
+} // namespace Tiled
@@ -0,0 +1,72 @@
+/*
+ * tintedpixmapcache.h
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of libtiled.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice,
+ *       this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include "tiled_global.h"
+
+#include <QColor>
+#include <QPixmap>
+
+namespace Tiled {
+
+/**
+ * A cache of tinted pixmaps. Tinting is expensive, so the tinted version of
+ * each pixmap (usually a whole tileset atlas) is created only once for each
+ * tint color.
+ *
+ * Pixmaps tinted with a pinned color are kept until the color is no longer
+ * pinned. Other pixmaps are kept until the cache runs out of space.
+ */
+class TILEDSHARED_EXPORT TintedPixmapCache
+{
+public:
+    struct Statistics
+    {
+        quint64 hits = 0;
+        quint64 misses = 0;
+        qint64 usedKilobytes = 0;
+        qint64 pinnedKilobytes = 0;
+        int pixmapCount = 0;
+    };
+
+    static QPixmap tinted(const QPixmap &pixmap, const QColor &color);
+
+    static void pinColor(const QColor &color);
+    static void unpinColor(const QColor &color);
+
+    static int maxSize();
+    static void setMaxSize(int megabytes);
+
+    static Statistics statistics();
+    static void resetStatistics();
+
+    static void clear();
+};
+
+} // namespace Tiled
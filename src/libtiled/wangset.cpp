@@ -538,9 +538,49 @@ const QVector<WangSet::WangIdAndCell> &WangSet::wangIdsAndCells() const
     return mWangIdAndCells;
 }
 
+/**
+ * Returns the indexes in wangIdsAndCells() of the entries matching the given
+ * \a wangId in the parts indicated by the \a mask, in their original order.
+ *
+ * An index is built for each used mask, so that the matching entries can be
+ * found without checking all of them.
+ */
+const QVector<int> &WangSet::wangIdsAndCellsMatching(WangId wangId, WangId mask) const
+{
+    static const QVector<int> noMatches;
+
+    const auto &entries = wangIdsAndCells();
+
+    const WangIdIndex *index = nullptr;
+
+    {
+        QReadLocker locker(&mWangIdIndexesLock);
+        auto it = mWangIdIndexes.find(mask);
+        if (it != mWangIdIndexes.end())
+            index = &it->second;
+    }
+
+    if (!index) {
+        QWriteLocker locker(&mWangIdIndexesLock);
+        auto it = mWangIdIndexes.find(mask);
+        if (it == mWangIdIndexes.end()) {
+            it = mWangIdIndexes.emplace(mask, WangIdIndex()).first;
+
+            WangIdIndex &newIndex = it->second;
+            for (int i = 0; i < entries.size(); ++i)
+                newIndex[entries.at(i).wangId & mask].append(i);
+        }
+        index = &it->second;
+    }
+
+    const auto match = index->find(wangId & mask);
+    return match == index->end() ? noMatches : match->second;
+}
+
 void WangSet::recalculateCells()
 {
     mWangIdAndCells.clear();
+    mWangIdIndexes.clear();
     mCellsDirty = false;
     mUniqueFullWangIdCount = 0;
 
@@ -796,13 +836,7 @@ bool WangSet::wangIdIsValid(WangId wangId, int colorCount)
  */
 bool WangSet::wangIdIsUsed(WangId wangId, WangId mask) const
 {
-    const quint64 maskedWangId = wangId & mask;
-
-    for (const auto &wangIdAndCell : wangIdsAndCells())
-        if ((wangIdAndCell.wangId & mask) == maskedWangId)
-            return true;
-
-    return false;
+    return !wangIdsAndCellsMatching(wangId, mask).isEmpty();
 }
 
 int WangSet::transitionPenalty(int colorA, int colorB) const
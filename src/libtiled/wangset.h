@@ -34,9 +34,12 @@
 
 #include <QHash>
 #include <QMultiHash>
+#include <QReadWriteLock>
 #include <QString>
 #include <QList>
 
+#include <unordered_map>
+
 #include "qtcompat_p.h"
 
 namespace Tiled {
@@ -286,6 +289,7 @@ public:
     };
 
     const QVector<WangIdAndCell> &wangIdsAndCells() const;
+    const QVector<int> &wangIdsAndCellsMatching(WangId wangId, WangId mask) const;
 
     QList<WangTile> sortedWangTiles() const;
 
@@ -334,6 +338,13 @@ private:
 
     QVector<WangIdAndCell> mWangIdAndCells;
 
+    // Indexes into mWangIdAndCells by masked WangId, for each mask that was
+    // looked up. Node-based containers are used so that references to the
+    // index entries stay valid while other masks are being added.
+    using WangIdIndex = std::unordered_map<quint64, QVector<int>>;
+    mutable std::unordered_map<quint64, WangIdIndex> mWangIdIndexes;
+    mutable QReadWriteLock mWangIdIndexesLock;
+
     int mMaximumColorDistance = 0;
     bool mColorDistancesDirty = true;
     bool mCellsDirty = true;
@@ -275,11 +275,15 @@ void AbstractTileFillTool::randomFill(TileLayer &tileLayer, const QRegion &regio
 
     const auto localRegion = region.translated(-tileLayer.position());
 
+    // A seeded engine is faster than the global one and makes the fill
+    // reproducible given its seed
+    SeededRandom random({ globalRandomEngine()() });
+
     for (const QRect &rect : localRegion) {
         for (int y = rect.top(); y <= rect.bottom(); ++y) {
             for (int x = rect.left(); x <= rect.right(); ++x) {
                 tileLayer.setCell(x, y,
-                                  mRandomCellPicker.pick());
+                                  mRandomCellPicker.pick(random));
             }
         }
     }
@@ -35,10 +35,12 @@
 #include "tile.h"
 
 #include <QDebug>
+#include <QElapsedTimer>
 #include <QRandomGenerator>
 #include <QtConcurrent>
 
 #include <algorithm>
+#include <numeric>
 #include <random>
 
 namespace Tiled {
@@ -72,6 +74,25 @@ static double randomDouble()
     return dist(engine);
 }
 
+enum RandomStream {
+    SkipStream,
+    OutputSetStream,
+};
+
+/**
+ * Returns a random number generator used to derive the random decisions made
+ * for a match from the RandomSeed option, the rule and the location of the
+ * match. This makes these decisions independent of the order in which the
+ * matches are found, and hence of the number of threads.
+ */
+static SeededRandom matchRandom(int seed, size_t ruleIndex, QPoint pos, RandomStream stream)
+{
+    return SeededRandom({ static_cast<quint32>(seed),
+                          ruleIndex,
+                          quint64(quint32(pos.x())) << 32 | quint32(pos.y()),
+                          quint64(stream) });
+}
+
 template<typename Type, typename Container, typename Pred, typename... Args>
 static inline Type &find_or_emplace(Container &container, Pred pred, Args&&... args)
 {
@@ -112,6 +133,153 @@ static MatchType matchType(const Tile *tile)
     return MatchType::Tile;
 }
 
+static qint64 regionArea(const QRegion &region)
+{
+    qint64 area = 0;
+    for (const QRect &rect : region)
+        area += qint64(rect.width()) * rect.height();
+    return area;
+}
+
+/**
+ * Indexing the input layers is only worth it for larger regions, like when
+ * automapping a whole map.
+ */
+static constexpr qint64 minimumIndexedArea = 64 * 64;
+
+/**
+ * Knows where the specific cells required by the rules can be found on the
+ * input layers. This enables checking each rule only at the locations where
+ * it can possibly match, rather than at every location in the region.
+ */
+struct MatchIndex
+{
+    using Positions = QVector<QPoint>;      // sorted by y, then x
+
+    struct Candidates
+    {
+        int x;                              // position relative to match location
+        int y;
+        const Positions *positions;
+    };
+
+    MatchIndex(const std::vector<QVector<RuleInputSet>> &ruleInputSets,
+               const QVector<const TileLayer*> &inputLayers,
+               const QVector<bool> &indexedLayers,
+               const QRegion &region);
+
+    // For each input layer, the positions of each cell used by any anchor
+    std::vector<std::unordered_map<Cell, Positions, CellHash>> layerCells;
+
+    // For each rule, whether the index can be used and where to find its
+    // candidate locations
+    std::vector<bool> ruleIndexed;
+    std::vector<QVector<Candidates>> ruleCandidates;
+};
+
+/**
+ * Indexes the cells used by the anchors of the given rules, on those of the
+ * \a inputLayers that are marked in \a indexedLayers, within \a region.
+ *
+ * For each input set, the anchor with the least occurrences is chosen. A
+ * rule can only use the index when each of its input sets has an anchor on
+ * an indexed layer.
+ */
+MatchIndex::MatchIndex(const std::vector<QVector<RuleInputSet>> &ruleInputSets,
+                       const QVector<const TileLayer*> &inputLayers,
+                       const QVector<bool> &indexedLayers,
+                       const QRegion &region)
+    : layerCells(inputLayers.size())
+    , ruleIndexed(ruleInputSets.size(), false)
+    , ruleCandidates(ruleInputSets.size())
+{
+    for (const QVector<RuleInputSet> &inputSets : ruleInputSets) {
+        for (const RuleInputSet &inputSet : inputSets) {
+            for (const RuleInputAnchor &anchor : inputSet.anchors) {
+                if (!indexedLayers.at(anchor.targetLayerIndex))
+                    continue;
+
+                auto &cells = layerCells[anchor.targetLayerIndex];
+                for (int c = anchor.firstCell; c < anchor.firstCell + anchor.cellCount; ++c)
+                    cells[inputSet.cells.at(c)];
+            }
+        }
+    }
+
+    // Each layer is indexed into its own entry, so this can be done in parallel
+    std::vector<int> layerIndexes(inputLayers.size());
+    std::iota(layerIndexes.begin(), layerIndexes.end(), 0);
+
+    QtConcurrent::blockingMap(layerIndexes, [&] (int layerIndex) {
+        auto &cells = layerCells[layerIndex];
+        if (cells.empty())
+            return;
+
+        const TileLayer &layer = *inputLayers.at(layerIndex);
+
+        for (const QRect &rect : region.intersected(layer.localBounds())) {
+            for (int y = rect.top(); y <= rect.bottom(); ++y) {
+                for (int x = rect.left(); x <= rect.right(); ++x) {
+                    const Cell &cell = layer.cellAt(x, y);
+                    if (cell.isEmpty())
+                        continue;
+
+                    auto it = cells.find(cell);
+                    if (it != cells.end())
+                        it->second.append(QPoint(x, y));
+                }
+            }
+        }
+
+        for (auto &entry : cells) {
+            std::sort(entry.second.begin(), entry.second.end(), [] (QPoint a, QPoint b) {
+                return a.y() < b.y() || (a.y() == b.y() && a.x() < b.x());
+            });
+        }
+    });
+
+    for (size_t r = 0; r < ruleInputSets.size(); ++r) {
+        QVector<Candidates> &candidates = ruleCandidates[r];
+        bool indexed = true;
+
+        for (const RuleInputSet &inputSet : ruleInputSets[r]) {
+            const RuleInputAnchor *bestAnchor = nullptr;
+            qsizetype bestCount = 0;
+
+            for (const RuleInputAnchor &anchor : inputSet.anchors) {
+                if (!indexedLayers.at(anchor.targetLayerIndex))
+                    continue;
+
+                const auto &cells = layerCells[anchor.targetLayerIndex];
+                qsizetype count = 0;
+                for (int c = anchor.firstCell; c < anchor.firstCell + anchor.cellCount; ++c)
+                    count += cells.at(inputSet.cells.at(c)).size();
+
+                if (!bestAnchor || count < bestCount) {
+                    bestAnchor = &anchor;
+                    bestCount = count;
+                }
+            }
+
+            if (!bestAnchor) {
+                indexed = false;
+                break;
+            }
+
+            const auto &cells = layerCells[bestAnchor->targetLayerIndex];
+            for (int c = bestAnchor->firstCell; c < bestAnchor->firstCell + bestAnchor->cellCount; ++c) {
+                const Positions &positions = cells.at(inputSet.cells.at(c));
+                if (!positions.isEmpty())
+                    candidates.append(Candidates { bestAnchor->x, bestAnchor->y, &positions });
+            }
+        }
+
+        ruleIndexed[r] = indexed;
+        if (!indexed)
+            candidates.clear();
+    }
+}
+
 /**
  * The compile context enables re-using temporarily allocated memory while
  * compiling the rules.
@@ -123,10 +291,19 @@ struct CompileContext
     QVector<Cell> inputCells;
 };
 
+/**
+ * A tile output of a rule whose copying has been deferred.
+ */
+struct TileOutput
+{
+    const TileLayer *from;
+    TileLayer *to;
+    QPoint offset;
+};
+
 struct ApplyContext
 {
-    ApplyContext(const RuleMapSetup &setup, QRegion *appliedRegion)
-        : appliedRegion(appliedRegion)
+    explicit ApplyContext(const RuleMapSetup &setup)
     {
         for (const OutputSet &outputSet : std::as_const(setup.mOutputSets))
             outputSets.add(&outputSet, outputSet.probability);
@@ -139,7 +316,10 @@ struct ApplyContext
 
     RandomPicker<const OutputSet*> outputSets;
 
-    QRegion *appliedRegion;
+    // When set, tile outputs are collected in tileOutputs instead of being
+    // copied right away, so that they can be copied in parallel.
+    bool deferTileOutputs = false;
+    QVector<TileOutput> tileOutputs;
 };
 
 
@@ -155,10 +335,15 @@ AutoMapper::AutoMapper(std::unique_ptr<Map> rulesMap, const QRegularExpression &
     , mRulesMapRenderer(MapRenderer::create(mRulesMap.get()))
     , mMapNameFilter(mapNameFilter)
 {
+    QElapsedTimer timer;
+    timer.start();
+
     setupRuleMapProperties();
 
     if (setupRuleMapLayers())
         setupRules();
+
+    mSetupTime = timer.nsecsElapsed();
 }
 
 AutoMapper::~AutoMapper()
@@ -260,6 +445,8 @@ void AutoMapper::setupRuleMapProperties()
             continue;
         if (checkOption(name, value, QLatin1String("NoOverlappingRules"), noOverlappingRules))
             continue;
+        if (checkOption(name, value, QLatin1String("RandomSeed"), mOptions.randomSeed))
+            continue;
         if (checkOption(name, value, QLatin1String("MatchInOrder"), mOptions.matchInOrder)) {
             mOptions.matchInOrderWasSet = true;
             continue;
@@ -523,11 +710,17 @@ bool AutoMapper::setupRuleMapLayers()
     if (setup.mOutputSets.empty())
         error += tr("No output_<name> layer found!") + QLatin1Char('\n');
 
+    setup.mSortedInputLayerNames = setup.mInputLayerNames.values();
+    setup.mSortedInputLayerNames.sort();
+
     // Make sure the input layers are always matched in the same order, which
     // significantly speeds up the matching logic.
     for (InputSet &set : setup.mInputSets) {
         std::sort(set.layers.begin(), set.layers.end(),
                   [] (const InputConditions &a, const InputConditions &b) { return a.layerName < b.layerName; });
+
+        for (InputConditions &conditions : set.layers)
+            conditions.layerIndex = setup.mSortedInputLayerNames.indexOf(conditions.layerName);
     }
 
     for (OutputSet &set : setup.mOutputSets)
@@ -754,22 +947,124 @@ static void collectCellsInRegion(const QVector<InputLayer> &list,
     }
 }
 
+/**
+ * Returns the layers in the target map matching each of the input layer
+ * names, by index. Missing layers are replaced by an empty dummy layer.
+ */
+QVector<const TileLayer*> AutoMapper::targetInputLayers(const AutoMappingContext &context) const
+{
+    QVector<const TileLayer*> inputLayers;
+    inputLayers.reserve(mRuleMapSetup.mSortedInputLayerNames.size());
+
+    for (const QString &name : std::as_const(mRuleMapSetup.mSortedInputLayerNames))
+        inputLayers.append(context.inputLayers.value(name, &dummy));
+
+    return inputLayers;
+}
+
+/**
+ * Returns the rules compiled for the given input layers.
+ *
+ * Since the compiled rules refer to the input layers by index, they only
+ * need to be compiled again when the set of present input layers changes.
+ * This avoids compiling all rules on each change while automapping while
+ * drawing.
+ */
+std::shared_ptr<const AutoMapper::CompiledRules>
+AutoMapper::compiledRules(const QVector<const TileLayer*> &inputLayers) const
+{
+    QVector<bool> inputLayersPresent;
+    inputLayersPresent.reserve(inputLayers.size());
+    for (const TileLayer *inputLayer : inputLayers)
+        inputLayersPresent.append(inputLayer != &dummy);
+
+    QMutexLocker locker(&mCompiledRulesMutex);
+
+    if (mCompiledRules &&
+            mCompiledRules->inputLayersPresent == inputLayersPresent &&
+            mCompiledRules->rulesMapTilesets == mRulesMap->tilesets()) {
+        return mCompiledRules;
+    }
+
+    auto compiledRules = std::make_shared<CompiledRules>();
+    compiledRules->rulesMapTilesets = mRulesMap->tilesets();
+    compiledRules->inputLayersPresent = inputLayersPresent;
+    compiledRules->ruleInputSets.resize(mRules.size());
+
+    // Each rule is compiled into its own entry, so this can be done in parallel
+    std::vector<size_t> ruleIndexes(mRules.size());
+    std::iota(ruleIndexes.begin(), ruleIndexes.end(), 0);
+
+    QtConcurrent::blockingMap(ruleIndexes, [&] (size_t ruleIndex) {
+        compileRule(compiledRules->ruleInputSets[ruleIndex], mRules[ruleIndex], inputLayersPresent);
+    });
+
+    // Assign ids to all used cells, which are needed for compiling the lookups
+    RuleCellIds &cellIds = compiledRules->cellIds;
+    for (const QVector<RuleInputSet> &inputSets : compiledRules->ruleInputSets)
+        for (const RuleInputSet &inputSet : inputSets)
+            for (const Cell &cell : inputSet.cells)
+                cellIds.add(cell);
+
+    QtConcurrent::blockingMap(ruleIndexes, [&] (size_t ruleIndex) {
+        for (RuleInputSet &inputSet : compiledRules->ruleInputSets[ruleIndex])
+            compileLookups(inputSet, cellIds);
+    });
+
+    mCompiledRules = std::move(compiledRules);
+    return mCompiledRules;
+}
+
 /**
  * Sets up a small data structure for this rule that is optimized for matching.
  */
 void AutoMapper::compileRule(QVector<RuleInputSet> &inputSets,
                              const Rule &rule,
-                             const AutoMappingContext &context) const
+                             const QVector<bool> &inputLayersPresent) const
 {
     CompileContext compileContext;
 
     for (const InputSet &inputSet : std::as_const(mRuleMapSetup.mInputSets)) {
         RuleInputSet index;
-        if (compileInputSet(index, inputSet, rule.inputRegion, compileContext, context))
+        if (compileInputSet(index, inputSet, rule.inputRegion, compileContext, inputLayersPresent))
             inputSets.append(std::move(index));
     }
 }
 
+/**
+ * Replaces the lists of cells of positions with many alternatives by a bitset
+ * of the accepted cell ids, so that checking a position takes constant time.
+ */
+void AutoMapper::compileLookups(RuleInputSet &inputSet, const RuleCellIds &cellIds)
+{
+    // Comparing a few cells is faster than looking up the id of a cell
+    constexpr int minimumLookupCells = 8;
+
+    const int words = (cellIds.count() + 63) / 64;
+    auto setBit = [&] (int offset, int id, bool value) {
+        const quint64 mask = quint64(1) << (id % 64);
+        quint64 &word = inputSet.lookupBits[offset + id / 64];
+        word = value ? word | mask : word & ~mask;
+    };
+
+    qsizetype nextCell = 0;
+
+    for (RuleInputLayerPos &pos : inputSet.positions) {
+        const qsizetype firstCell = std::exchange(nextCell, nextCell + pos.anyCount + pos.noneCount);
+        if (pos.anyCount + pos.noneCount < minimumLookupCells)
+            continue;
+
+        // After optimization, only one of the lists is used
+        const bool accept = pos.anyCount > 0;
+
+        pos.lookup = static_cast<int>(inputSet.lookupBits.size());
+        inputSet.lookupBits.insert(inputSet.lookupBits.size(), words, accept ? 0 : ~quint64(0));
+
+        for (qsizetype c = firstCell; c < nextCell; ++c)
+            setBit(pos.lookup, cellIds.id(inputSet.cells.at(c)), accept);
+    }
+}
+
 /**
  * After optimization, only one of \a anyOf or \a noneOf can contain any cells.
  *
@@ -828,7 +1123,7 @@ bool AutoMapper::compileInputSet(RuleInputSet &index,
                                  const InputSet &inputSet,
                                  const QRegion &inputRegion,
                                  CompileContext &compileContext,
-                                 const AutoMappingContext &context) const
+                                 const QVector<bool> &inputLayersPresent) const
 {
     const QPoint topLeft = inputRegion.boundingRect().topLeft();
 
@@ -841,7 +1136,9 @@ bool AutoMapper::compileInputSet(RuleInputSet &index,
         bool canMatch = true;
 
         RuleInputLayer layer;
-        layer.targetLayer = context.inputLayers.value(conditions.layerName, &dummy);
+        layer.targetLayerIndex = conditions.layerIndex;
+
+        const bool layerPresent = inputLayersPresent.at(conditions.layerIndex);
 
         forEachPointInRegion(inputRegion, [&] (int x, int y) {
             anyOf.clear();
@@ -937,7 +1234,7 @@ bool AutoMapper::compileInputSet(RuleInputSet &index,
             // When the input layer is missing, it is considered empty. In this
             // case, we can drop this input set when empty tiles are not
             // allowed here.
-            if (layer.targetLayer == &dummy) {
+            if (!layerPresent) {
                 const bool emptyAllowed = (anyOf.isEmpty() ||
                                            std::any_of(anyOf.cbegin(),
                                                        anyOf.cend(),
@@ -951,6 +1248,20 @@ bool AutoMapper::compileInputSet(RuleInputSet &index,
             }
 
             if (anyOf.size() > 0 || noneOf.size() > 0) {
+                // Positions requiring specific tiles can be used to find the
+                // candidate locations for this input set.
+                if (!anyOf.isEmpty() && std::none_of(anyOf.cbegin(),
+                                                     anyOf.cend(),
+                                                     [] (const Cell &cell) { return cell.isEmpty(); })) {
+                    index.anchors.append(RuleInputAnchor {
+                                             conditions.layerIndex,
+                                             x - topLeft.x(),
+                                             y - topLeft.y(),
+                                             static_cast<int>(index.cells.size()),
+                                             static_cast<int>(anyOf.size())
+                                         });
+                }
+
                 index.cells.append(anyOf);
                 index.cells.append(noneOf);
 
@@ -975,10 +1286,42 @@ bool AutoMapper::compileInputSet(RuleInputSet &index,
     return true;
 }
 
+/**
+ * Returns whether any of the given \a inputSets refers to an input layer for
+ * which \a layers is set.
+ */
+static bool readsLayers(const QVector<RuleInputSet> &inputSets,
+                        const QVector<bool> &layers)
+{
+    for (const RuleInputSet &inputSet : inputSets)
+        for (const RuleInputLayer &layer : inputSet.layers)
+            if (layers.at(layer.targetLayerIndex))
+                return true;
+    return false;
+}
+
 void AutoMapper::autoMap(const QRegion &where,
-                         QRegion *appliedRegion,
                          AutoMappingContext &context) const
 {
+    QElapsedTimer timer;
+    timer.start();
+
+    RulesMapProfile *profile = nullptr;
+    if (context.profiles) {
+        profile = &context.profiles->emplace_back();
+        profile->rulesMapFileName = rulesMapFileName();
+        profile->setupTime = mSetupTime;
+        profile->rules.resize(mRules.size());
+        for (size_t i = 0; i < mRules.size(); ++i)
+            profile->rules[i].bounds = mRules[i].inputRegion.boundingRect();
+    }
+
+    auto addBandStatistics = [] (RuleProfile &ruleProfile, const BandMatches &matches) {
+        ruleProfile.positionsTested += matches.positionsTested;
+        ruleProfile.matches += matches.positions.size();
+        ruleProfile.matchTime += matches.time;
+    };
+
     QRegion applyRegion;
 
     // first resize the active area if applicable
@@ -1012,9 +1355,12 @@ void AutoMapper::autoMap(const QRegion &where,
                 const QString &name = it.value();
 
                 switch (it.key()->layerType()) {
-                case Layer::TileLayerType:
-                    context.outputTileLayers.value(name)->erase(regionToErase);
+                case Layer::TileLayerType: {
+                    TileLayer *outputLayer = context.outputTileLayers.value(name);
+                    outputLayer->erase(regionToErase);
+                    context.changedRegions[outputLayer] |= regionToErase;
                     break;
+                }
                 case Layer::ObjectGroupType: {
                     const auto objects = objectsToErase(context.targetDocument,
                                                         context.outputObjectGroups.value(name),
@@ -1042,65 +1388,192 @@ void AutoMapper::autoMap(const QRegion &where,
             get = &getBoundCell;
     }
 
-    ApplyContext applyContext(mRuleMapSetup, appliedRegion);
+    ApplyContext applyContext(mRuleMapSetup);
+
+    const QVector<const TileLayer*> inputLayers = targetInputLayers(context);
+    QElapsedTimer compileTimer;
+    compileTimer.start();
+
+    const auto compiledRules = this->compiledRules(inputLayers);
+
+    if (profile)
+        profile->compileTime = compileTimer.nsecsElapsed();
+    const auto &ruleInputSets = compiledRules->ruleInputSets;
+
+    // Input layers that are also output layers see the changes made by
+    // earlier rules (and earlier matches of the same rule) when matching in
+    // order.
+    QVector<bool> inputLayerIsOutput;
+    inputLayerIsOutput.reserve(inputLayers.size());
+    for (const TileLayer *inputLayer : inputLayers)
+        inputLayerIsOutput.append(contains(context.outputTileLayers, inputLayer));
+
+    // For large regions, index where the tiles required by the rules are
+    // found, so that rules are only checked where they can possibly match.
+    // This can't be used when reading cells from beyond the map boundaries,
+    // nor for layers that change while matching.
+    std::unique_ptr<MatchIndex> matchIndex;
+    if (get == &getCell && regionArea(applyRegion) >= minimumIndexedArea) {
+        QVector<bool> indexedLayers(inputLayers.size(), true);
+        if (mOptions.matchInOrder) {
+            for (int i = 0; i < inputLayers.size(); ++i)
+                indexedLayers[i] = !inputLayerIsOutput.at(i);
+        }
 
-    if (mOptions.matchInOrder) {
+        // Rules can read cells up to their size beyond the apply region
+        int ruleWidth = 0;
+        int ruleHeight = 0;
         for (const Rule &rule : mRules) {
+            const QRect inputBounds = rule.inputRegion.boundingRect();
+            ruleWidth = std::max(ruleWidth, inputBounds.width());
+            ruleHeight = std::max(ruleHeight, inputBounds.height());
+        }
+
+        QRegion readRegion;
+        for (const QRect &rect : applyRegion)
+            readRegion |= rect.adjusted(-ruleWidth, -ruleHeight, ruleWidth, ruleHeight);
+
+        matchIndex = std::make_unique<MatchIndex>(ruleInputSets,
+                                                  inputLayers,
+                                                  indexedLayers,
+                                                  readRegion);
+    }
+
+    // Tile outputs are copied after all matches of a rule have been applied,
+    // which allows doing it in parallel. This is not done when outputs may
+    // wrap around the map.
+    const bool deferTileOutputs = !(mOptions.wrapBorder && !context.targetMap->infinite());
+
+    if (mOptions.matchInOrder) {
+
+        for (size_t i = 0; i < mRules.size(); ++i) {
+            const Rule &rule = mRules[i];
             if (rule.options.disabled)
                 continue;
 
-            matchRule(rule, applyRegion, get, [&] (QPoint pos) {
-                applyRule(rule, pos, applyContext, context);
-            }, context);
+            QVector<MatchBand> bands;
+            addMatchBands(bands, i, applyRegion, context);
+
+            RuleProfile *ruleProfile = profile ? &profile->rules[i] : nullptr;
+            QElapsedTimer ruleTimer;
+            ruleTimer.start();
+
+            if (readsLayers(ruleInputSets[i], inputLayerIsOutput)) {
+                // This rule may affect its own matches, so it needs to be
+                // applied directly after each match.
+                applyContext.deferTileOutputs = false;
+                for (const MatchBand &band : std::as_const(bands)) {
+                    const qint64 tested = matchBand(band, *compiledRules, inputLayers, get, nullptr, [&] (QPoint pos) {
+                        const bool applied = applyRule(i, pos, applyContext, context);
+                        if (ruleProfile) {
+                            ++ruleProfile->matches;
+                            ruleProfile->appliedOutputs += applied;
+                        }
+                    });
+                    if (ruleProfile)
+                        ruleProfile->positionsTested += tested;
+                }
+
+                // Applying can't be measured separately here
+                if (ruleProfile) {
+                    ruleProfile->matchTime += ruleTimer.nsecsElapsed();
+                    ruleTimer.restart();
+                }
+            } else {
+                applyContext.deferTileOutputs = deferTileOutputs;
+                const auto result = matchBands(bands, *compiledRules, inputLayers, get,
+                                               matchIndex.get());
+                if (ruleProfile) {
+                    for (const BandMatches &matches : result)
+                        addBandStatistics(*ruleProfile, matches);
+                    ruleTimer.restart();
+                }
+
+                for (const BandMatches &matches : result) {
+                    for (const QPoint pos : matches.positions) {
+                        const bool applied = applyRule(i, pos, applyContext, context);
+                        if (ruleProfile)
+                            ruleProfile->appliedOutputs += applied;
+                    }
+                }
+            }
+
+            copyTileOutputs(rule, applyContext, context);
             applyContext.appliedRegions.clear();
+
+            if (ruleProfile)
+                ruleProfile->applyTime += ruleTimer.nsecsElapsed();
         }
     } else {
-        auto collectMatches = [&] (const Rule &rule) {
-            QVector<QPoint> positions;
-            if (!rule.options.disabled)
-                matchRule(rule, applyRegion, get, [&] (QPoint pos) { positions.append(pos); }, context);
-            return positions;
-        };
-#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
-        auto result = QtConcurrent::blockingMapped(mRules, collectMatches);
-#else
-        struct MatchRule
-        {
-            using result_type = QVector<QPoint>;
+        QVector<MatchBand> bands;
+        for (size_t i = 0; i < mRules.size(); ++i)
+            if (!mRules[i].options.disabled)
+                addMatchBands(bands, i, applyRegion, context);
+
+        const auto result = matchBands(bands, *compiledRules, inputLayers, get,
+                                       matchIndex.get());
+
+        applyContext.deferTileOutputs = deferTileOutputs;
 
-            std::function<result_type(const Rule&)> collectMatches;
+        // Apply the matches in the same order as when matching serially
+        for (int b = 0; b < bands.size(); ++b) {
+            const size_t ruleIndex = bands.at(b).ruleIndex;
 
-            result_type operator()(const Rule &rule)
-            {
-                return collectMatches(rule);
+            RuleProfile *ruleProfile = profile ? &profile->rules[ruleIndex] : nullptr;
+            QElapsedTimer applyTimer;
+            if (ruleProfile) {
+                addBandStatistics(*ruleProfile, result.at(b));
+                applyTimer.start();
             }
-        };
 
-        const auto result = QtConcurrent::blockingMapped<QVector<QVector<QPoint>>>(mRules,
-                                                                                   MatchRule { collectMatches });
-#endif
+            for (const QPoint pos : result.at(b).positions) {
+                const bool applied = applyRule(ruleIndex, pos, applyContext, context);
+                if (ruleProfile)
+                    ruleProfile->appliedOutputs += applied;
+            }
 
-        for (size_t i = 0; i < mRules.size(); ++i) {
-            const Rule &rule = mRules[i];
-            for (const QPoint pos : result[i])
-                applyRule(rule, pos, applyContext, context);
-            applyContext.appliedRegions.clear();
+            if (b + 1 == bands.size() || bands.at(b + 1).ruleIndex != ruleIndex) {
+                copyTileOutputs(mRules[ruleIndex], applyContext, context);
+                applyContext.appliedRegions.clear();
+            }
+
+            if (ruleProfile)
+                ruleProfile->applyTime += applyTimer.nsecsElapsed();
         }
     }
+
+    if (profile)
+        profile->wallTime = timer.nsecsElapsed();
 }
 
 /**
  * Checks whether the given \a inputSet matches at the given \a offset.
  */
-static bool matchInputIndex(const RuleInputSet &inputSet, QPoint offset, AutoMapper::GetCell getCell)
+static bool matchInputIndex(const RuleInputSet &inputSet,
+                            const RuleCellIds &cellIds,
+                            const QVector<const TileLayer*> &inputLayers,
+                            QPoint offset, AutoMapper::GetCell getCell)
 {
     qsizetype nextPos = 0;
     qsizetype nextCell = 0;
 
     for (const RuleInputLayer &layer : inputSet.layers) {
+        const TileLayer &targetLayer = *inputLayers[layer.targetLayerIndex];
+
         for (auto p = std::exchange(nextPos, nextPos + layer.posCount); p < nextPos; ++p) {
             const RuleInputLayerPos &pos = inputSet.positions[p];
-            const Cell &cell = getCell(pos.x + offset.x(), pos.y + offset.y(), *layer.targetLayer);
+            const Cell &cell = getCell(pos.x + offset.x(), pos.y + offset.y(), targetLayer);
+
+            // Positions with many alternatives use a bitset of accepted cells
+            if (pos.lookup != -1) {
+                nextCell += pos.anyCount + pos.noneCount;
+
+                const int id = cellIds.id(cell);
+                if (!(inputSet.lookupBits.at(pos.lookup + id / 64) & (quint64(1) << (id % 64))))
+                    return false;
+
+                continue;
+            }
 
             // Match may succeed if any of the "any" tiles are seen, or when
             // there are no "any" tiles for this location.
@@ -1129,22 +1602,22 @@ static bool matchInputIndex(const RuleInputSet &inputSet, QPoint offset, AutoMap
     return true;
 }
 
-static bool matchRuleAtOffset(const QVector<RuleInputSet> &inputSets, QPoint offset, AutoMapper::GetCell getCell)
+static bool matchRuleAtOffset(const QVector<RuleInputSet> &inputSets,
+                              const RuleCellIds &cellIds,
+                              const QVector<const TileLayer*> &inputLayers,
+                              QPoint offset, AutoMapper::GetCell getCell)
 {
     return std::any_of(inputSets.begin(),
                        inputSets.end(),
-                       [=] (const RuleInputSet &index) { return matchInputIndex(index, offset, getCell); });
+                       [&] (const RuleInputSet &index) { return matchInputIndex(index, cellIds, inputLayers, offset, getCell); });
 }
 
-void AutoMapper::matchRule(const Rule &rule,
-                           const QRegion &matchRegion,
-                           GetCell getCell,
-                           const std::function<void(QPoint pos)> &matched,
-                           const AutoMappingContext &context) const
+void AutoMapper::addMatchBands(QVector<MatchBand> &bands,
+                               size_t ruleIndex,
+                               const QRegion &matchRegion,
+                               const AutoMappingContext &context) const
 {
-    QVector<RuleInputSet> inputSets;
-    compileRule(inputSets, rule, context);
-
+    const Rule &rule = mRules[ruleIndex];
     const QRect inputBounds = rule.inputRegion.boundingRect();
 
     // This is really the rule size - 1, since when applying the rule we will
@@ -1168,33 +1641,180 @@ void AutoMapper::matchRule(const Rule &rule,
                                  context.targetMap->height() - ruleHeight);
     }
 
+    // Number of rows checked per band, balancing the overhead per band
+    // against the ability to spread the work evenly over the threads.
+    constexpr int rowsPerBand = CHUNK_SIZE;
+    const int bandHeight = rowsPerBand * rule.options.modY;
+
     for (const QRect &rect : ruleMatchRegion) {
         const int startX = rect.left() + (rect.left() + rule.options.offsetX) % rule.options.modX;
         const int startY = rect.top() + (rect.top() + rule.options.offsetY) % rule.options.modY;
 
-        for (int y = startY; y <= rect.bottom(); y += rule.options.modY) {
-            for (int x = startX; x <= rect.right(); x += rule.options.modX) {
-                if (rule.options.skipChance != 0.0 && randomDouble() < rule.options.skipChance)
+        for (int y = startY; y <= rect.bottom(); y += bandHeight) {
+            bands.append(MatchBand {
+                             ruleIndex,
+                             startX,
+                             y,
+                             rect.right(),
+                             std::min(rect.bottom(), y + bandHeight - 1)
+                         });
+        }
+    }
+}
+
+qint64 AutoMapper::matchBand(const MatchBand &band,
+                             const CompiledRules &compiledRules,
+                             const QVector<const TileLayer*> &inputLayers,
+                             GetCell getCell,
+                             const MatchIndex *matchIndex,
+                             const std::function<void(QPoint pos)> &matched) const
+{
+    const RuleOptions &options = mRules[band.ruleIndex].options;
+    const QVector<RuleInputSet> &inputSets = compiledRules.ruleInputSets[band.ruleIndex];
+    const RuleCellIds &cellIds = compiledRules.cellIds;
+
+    auto skip = [&] (QPoint pos) {
+        if (options.skipChance == 0.0)
+            return false;
+
+        const double random = mOptions.randomSeed
+                ? matchRandom(mOptions.randomSeed, band.ruleIndex, pos, SkipStream).real()
+                : randomDouble();
+
+        return random < options.skipChance;
+    };
+
+    if (matchIndex && matchIndex->ruleIndexed[band.ruleIndex]) {
+        QVector<QPoint> candidates;
+
+        for (const MatchIndex::Candidates &c : matchIndex->ruleCandidates[band.ruleIndex]) {
+            const MatchIndex::Positions &positions = *c.positions;
+
+            // Find the positions in the rows covered by this band
+            auto it = std::lower_bound(positions.begin(), positions.end(), band.startY + c.y,
+                                       [] (QPoint pos, int y) { return pos.y() < y; });
+
+            for (; it != positions.end() && it->y() <= band.bottom + c.y; ++it) {
+                const int x = it->x() - c.x;
+                const int y = it->y() - c.y;
+
+                if (x < band.startX || x > band.right)
+                    continue;
+                if ((x - band.startX) % options.modX || (y - band.startY) % options.modY)
                     continue;
 
-                if (matchRuleAtOffset(inputSets, QPoint(x, y), getCell))
-                    matched(QPoint(x, y));
+                candidates.append(QPoint(x, y));
             }
         }
+
+        // Check the candidates in the same order as when checking all
+        // locations, without checking any location twice.
+        std::sort(candidates.begin(), candidates.end(), [] (QPoint a, QPoint b) {
+            return a.y() < b.y() || (a.y() == b.y() && a.x() < b.x());
+        });
+        candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+
+        qint64 positionsTested = 0;
+        for (const QPoint pos : std::as_const(candidates)) {
+            if (skip(pos))
+                continue;
+
+            ++positionsTested;
+            if (matchRuleAtOffset(inputSets, cellIds, inputLayers, pos, getCell))
+                matched(pos);
+        }
+        return positionsTested;
+    }
+
+    qint64 positionsTested = 0;
+    for (int y = band.startY; y <= band.bottom; y += options.modY) {
+        for (int x = band.startX; x <= band.right; x += options.modX) {
+            if (skip(QPoint(x, y)))
+                continue;
+
+            ++positionsTested;
+            if (matchRuleAtOffset(inputSets, cellIds, inputLayers, QPoint(x, y), getCell))
+                matched(QPoint(x, y));
+        }
+    }
+    return positionsTested;
+}
+
+QVector<AutoMapper::BandMatches> AutoMapper::matchBands(const QVector<MatchBand> &bands,
+                                                       const CompiledRules &compiledRules,
+                                                       const QVector<const TileLayer*> &inputLayers,
+                                                       GetCell getCell,
+                                                       const MatchIndex *matchIndex) const
+{
+    auto collectMatches = [&] (const MatchBand &band) {
+        QElapsedTimer timer;
+        timer.start();
+
+        BandMatches matches;
+        matches.positionsTested = matchBand(band, compiledRules, inputLayers, getCell, matchIndex,
+                                            [&] (QPoint pos) { matches.positions.append(pos); });
+        matches.time = timer.nsecsElapsed();
+        return matches;
+    };
+
+    // Small areas, like when automapping while drawing, are not worth the
+    // overhead of involving the thread pool.
+    constexpr qint64 minimumParallelArea = 64 * 64;
+    qint64 area = 0;
+    for (const MatchBand &band : bands)
+        area += qint64(band.right - band.startX + 1) * (band.bottom - band.startY + 1);
+
+    if (bands.size() < 2 || area < minimumParallelArea) {
+        QVector<BandMatches> result;
+        result.reserve(bands.size());
+        for (const MatchBand &band : bands)
+            result.append(collectMatches(band));
+        return result;
     }
+
+    // The bands of all rules are handed out to the threads of the pool as
+    // they become available, so the work is spread evenly regardless of the
+    // number of rules and the size of the region.
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+    return QtConcurrent::blockingMapped<QVector<BandMatches>>(bands, collectMatches);
+#else
+    struct MatchBandFunctor
+    {
+        using result_type = BandMatches;
+
+        std::function<result_type(const MatchBand &)> collectMatches;
+
+        result_type operator()(const MatchBand &band)
+        {
+            return collectMatches(band);
+        }
+    };
+
+    return QtConcurrent::blockingMapped<QVector<BandMatches>>(bands,
+                                                              MatchBandFunctor { collectMatches });
+#endif
 }
 
-void AutoMapper::applyRule(const Rule &rule, QPoint pos,
+bool AutoMapper::applyRule(size_t ruleIndex, QPoint pos,
                            ApplyContext &applyContext,
                            AutoMappingContext &context) const
 {
     Q_ASSERT(!applyContext.outputSets.isEmpty());
 
-    // Translate the position to adjust to the location of the rule.
-    pos -= rule.inputRegion.boundingRect().topLeft();
+    const Rule &rule = mRules[ruleIndex];
 
     // choose by chance which group of rule_layers should be used:
-    const OutputSet &ruleOutput = *applyContext.outputSets.pick();
+    const OutputSet *outputSet;
+    if (mOptions.randomSeed) {
+        SeededRandom random = matchRandom(mOptions.randomSeed, ruleIndex, pos, OutputSetStream);
+        outputSet = applyContext.outputSets.pick(random);
+    } else {
+        outputSet = applyContext.outputSets.pick();
+    }
+    const OutputSet &ruleOutput = *outputSet;
+
+    // Translate the position to adjust to the location of the rule.
+    pos -= rule.inputRegion.boundingRect().topLeft();
 
     if (rule.options.noOverlappingOutput) {
         // check if there are no overlaps within this rule.
@@ -1236,7 +1856,7 @@ void AutoMapper::applyRule(const Rule &rule, QPoint pos,
         });
 
         if (overlap)
-            return;
+            return false;
 
         // Remember the newly applied region
         std::for_each(ruleRegionInLayer.keyValueBegin(),
@@ -1249,14 +1869,14 @@ void AutoMapper::applyRule(const Rule &rule, QPoint pos,
         });
     }
 
-    copyMapRegion(rule, pos, ruleOutput, context);
+    copyMapRegion(rule, pos, ruleOutput, applyContext, context);
 
-    if (applyContext.appliedRegion)
-        *applyContext.appliedRegion |= rule.outputRegion.translated(pos.x(), pos.y());
+    return true;
 }
 
 void AutoMapper::copyMapRegion(const Rule &rule, QPoint offset,
                                const OutputSet &ruleOutput,
+                               ApplyContext &applyContext,
                                AutoMappingContext &context) const
 {
     const QRegion &outputRegion = rule.outputRegion;
@@ -1275,15 +1895,25 @@ void AutoMapper::copyMapRegion(const Rule &rule, QPoint offset,
             if (!rule.options.ignoreLock && !toTileLayer->isUnlocked())
                 continue;
 
-            if (!context.touchedTileLayers.isEmpty())
-                appendUnique<const TileLayer*>(context.touchedTileLayers, toTileLayer);
-
             to = toTileLayer;
-            for (const QRect &rect : outputRegion) {
-                copyTileRegion(fromTileLayer, rect, toTileLayer,
-                               rect.x() + offset.x(), rect.y() + offset.y(),
-                               context);
+            if (applyContext.deferTileOutputs) {
+                applyContext.tileOutputs.append(TileOutput { fromTileLayer, toTileLayer, offset });
+            } else {
+                for (const QRect &rect : outputRegion) {
+                    copyTileRegion(fromTileLayer, rect, toTileLayer,
+                                   rect.x() + offset.x(), rect.y() + offset.y(),
+                                   context);
+                }
+            }
+
+            QRegion changedRegion = outputRegion.translated(offset);
+            if (mOptions.wrapBorder && !context.targetMap->infinite()) {
+                // Parts of the output may have wrapped around
+                const QRect mapRect(0, 0, context.targetMap->width(), context.targetMap->height());
+                if (!mapRect.contains(changedRegion.boundingRect()))
+                    changedRegion = mapRect;
             }
+            context.changedRegions[toTileLayer] |= changedRegion;
             break;
         }
         case Layer::ObjectGroupType: {
@@ -1329,6 +1959,124 @@ void AutoMapper::copyMapRegion(const Rule &rule, QPoint offset,
     }
 }
 
+void AutoMapper::copyTileOutputs(const Rule &rule,
+                                 ApplyContext &applyContext,
+                                 const AutoMappingContext &context) const
+{
+    const QVector<TileOutput> outputs = std::exchange(applyContext.tileOutputs, {});
+    if (outputs.isEmpty())
+        return;
+
+    // Copying a few outputs is not worth involving the thread pool
+    constexpr int minimumParallelOutputs = 256;
+    if (outputs.size() < minimumParallelOutputs) {
+        for (const TileOutput &output : outputs) {
+            for (const QRect &rect : rule.outputRegion) {
+                copyTileRegion(output.from, rect, output.to,
+                               rect.x() + output.offset.x(), rect.y() + output.offset.y(),
+                               context);
+            }
+        }
+        return;
+    }
+
+    // The area written to in each target layer is split into bands of chunk
+    // rows. Each band is handled by a single thread, which copies the outputs
+    // affecting it in their original order into copies of the target chunks
+    // in its row. Since the bands don't overlap, the chunks can then be put
+    // back in any order while still giving the same result as copying the
+    // outputs one by one.
+    struct Band
+    {
+        TileLayer *to;
+        int top;
+        QVector<int> outputs;
+        QHash<int, Chunk> chunks;   // by chunk column
+    };
+
+    const QRect outputBounds = rule.outputRegion.boundingRect();
+    const bool fixedSize = !context.targetMap->infinite();
+
+    std::vector<Band> bands;
+    QHash<QPair<TileLayer*, int>, size_t> bandIndexes;
+
+    for (int i = 0; i < outputs.size(); ++i) {
+        const TileOutput &output = outputs.at(i);
+
+        QRect bounds = outputBounds.translated(output.offset);
+        if (fixedSize)
+            bounds &= QRect(0, 0, output.to->width(), output.to->height());
+        if (bounds.isEmpty())
+            continue;
+
+        const int firstRow = bounds.top() >> CHUNK_BITS;
+        const int lastRow = bounds.bottom() >> CHUNK_BITS;
+
+        for (int row = firstRow; row <= lastRow; ++row) {
+            const auto key = qMakePair(output.to, row);
+            auto it = bandIndexes.find(key);
+            if (it == bandIndexes.end()) {
+                it = bandIndexes.insert(key, bands.size());
+                bands.push_back(Band { output.to, row << CHUNK_BITS, {}, {} });
+            }
+            bands[it.value()].outputs.append(i);
+        }
+    }
+
+    QtConcurrent::blockingMap(bands, [&] (Band &band) {
+        // The target layers are only read while the bands are processed
+        const TileLayer *target = band.to;
+
+        for (const int i : std::as_const(band.outputs)) {
+            const TileOutput &output = outputs.at(i);
+
+            for (const QRect &rect : rule.outputRegion) {
+                QRect dest = rect.translated(output.offset);
+                dest.setTop(std::max(dest.top(), band.top));
+                dest.setBottom(std::min(dest.bottom(), band.top + CHUNK_SIZE - 1));
+                if (fixedSize)
+                    dest &= QRect(0, 0, target->width(), target->height());
+
+                for (int x = dest.left(); x <= dest.right();) {
+                    const int chunkX = x >> CHUNK_BITS;
+                    const int endX = std::min(dest.right(), ((chunkX + 1) << CHUNK_BITS) - 1);
+
+                    auto chunkIt = band.chunks.find(chunkX);
+                    if (chunkIt == band.chunks.end()) {
+                        const Chunk *existing = target->findChunk(x, band.top);
+                        chunkIt = band.chunks.insert(chunkX, existing ? *existing : Chunk());
+                    }
+                    Chunk &chunk = chunkIt.value();
+
+                    for (int y = dest.top(); y <= dest.bottom(); ++y) {
+                        for (int _x = x; _x <= endX; ++_x) {
+                            const Cell &cell = output.from->cellAt(_x - output.offset.x(),
+                                                                   y - output.offset.y());
+
+                            switch (matchType(cell.tile())) {
+                            case Tiled::MatchType::Tile:
+                                chunk.setCell(_x & CHUNK_MASK, y & CHUNK_MASK, cell);
+                                break;
+                            case Tiled::MatchType::Empty:
+                                chunk.setCell(_x & CHUNK_MASK, y & CHUNK_MASK, Cell());
+                                break;
+                            default:
+                                break;
+                            }
+                        }
+                    }
+
+                    x = endX + 1;
+                }
+            }
+        }
+    });
+
+    for (const Band &band : bands)
+        for (auto it = band.chunks.cbegin(); it != band.chunks.cend(); ++it)
+            band.to->setChunk(it.key() << CHUNK_BITS, band.top, &it.value());
+}
+
 void AutoMapper::copyTileRegion(const TileLayer *srcLayer, QRect rect,
                                 TileLayer *dstLayer, int dstX, int dstY,
                                 const AutoMappingContext &context) const
@@ -28,10 +28,12 @@
 
 #include <QList>
 #include <QMap>
+#include <QMutex>
 #include <QRegion>
 #include <QRegularExpression>
 #include <QSet>
 #include <QString>
+#include <QStringList>
 #include <QVector>
 
 #include <memory>
@@ -61,6 +63,7 @@ struct InputConditions
     InputConditions(const QString &layerName) : layerName(layerName) {}
 
     QString layerName;
+    int layerIndex = -1;                // index in RuleMapSetup::mSortedInputLayerNames
     QVector<InputLayer> listYes;        // "input"
     QVector<InputLayer> listNo;         // "inputnot"
 };
@@ -148,13 +151,14 @@ struct RuleMapSetup
     std::vector<RuleOptionsArea> mRuleOptionsAreas;
 
     QSet<QString> mInputLayerNames;
+    QStringList mSortedInputLayerNames;     // determines the input layer indexes
     QSet<QString> mOutputTileLayerNames;
     QSet<QString> mOutputObjectGroupNames;
 };
 
 struct RuleInputLayer
 {
-    const TileLayer *targetLayer = nullptr;   // reference to layer in target map
+    int targetLayerIndex = -1;      // index of the input layer in target map
     int posCount = 0;
 };
 
@@ -164,6 +168,63 @@ struct RuleInputLayerPos
     int y;
     int anyCount;                   // any of these cells
     int noneCount;                  // none of these cells
+    int lookup = -1;                // index of the accepted cells bitset
+};
+
+struct CellHash
+{
+    size_t operator()(const Cell &cell) const
+    {
+        return std::hash<const Tileset*>()(cell.tileset())
+                ^ (static_cast<size_t>(cell.tileId()) << 4)
+                ^ static_cast<size_t>(cell.flags());
+    }
+};
+
+/**
+ * Assigns an id to each of the cells used by the compiled rules, so that
+ * positions with many alternatives can look up whether a cell is accepted
+ * in a bitset. The empty cell and any cells not used by the rules get their
+ * own id.
+ */
+class RuleCellIds
+{
+public:
+    static constexpr int EmptyId = 0;
+
+    void add(const Cell &cell)
+    {
+        if (!cell.isEmpty())
+            mIds.emplace(cell, static_cast<int>(mIds.size()) + 1);
+    }
+
+    int id(const Cell &cell) const
+    {
+        if (cell.isEmpty())
+            return EmptyId;
+        auto it = mIds.find(cell);
+        return it != mIds.end() ? it->second : otherId();
+    }
+
+    int otherId() const { return static_cast<int>(mIds.size()) + 1; }
+    int count() const { return static_cast<int>(mIds.size()) + 2; }
+
+private:
+    std::unordered_map<Cell, int, CellHash> mIds;
+};
+
+/**
+ * A position at which only specific non-empty cells can match. The locations
+ * of these cells on the target layer are the only candidate locations for
+ * the input set.
+ */
+struct RuleInputAnchor
+{
+    int targetLayerIndex;           // index of the input layer in target map
+    int x;                          // position relative to match location
+    int y;
+    int firstCell;                  // index of the first of the "any" cells
+    int cellCount;
 };
 
 /**
@@ -175,10 +236,40 @@ struct RuleInputSet
     QVector<RuleInputLayer> layers;
     QVector<RuleInputLayerPos> positions;
     QVector<Cell> cells;
+    QVector<RuleInputAnchor> anchors;
+    QVector<quint64> lookupBits;    // bitsets indexed by RuleCellIds
 };
 
 struct CompileContext;
 struct ApplyContext;
+struct MatchIndex;
+
+/**
+ * Statistics about applying a single rule, collected when profiling.
+ * Times are in nanoseconds.
+ */
+struct RuleProfile
+{
+    QRect bounds;                   // Location of the rule in the rules map
+    qint64 positionsTested = 0;
+    qint64 matches = 0;
+    qint64 appliedOutputs = 0;
+    qint64 matchTime = 0;           // Summed over all threads
+    qint64 applyTime = 0;
+};
+
+/**
+ * Statistics about applying the rules of a rules map, collected when
+ * profiling. Times are in nanoseconds.
+ */
+struct RulesMapProfile
+{
+    QString rulesMapFileName;
+    qint64 setupTime = 0;           // Setting up the rules from the rules map
+    qint64 compileTime = 0;         // Compiling the rules for the target map
+    qint64 wallTime = 0;
+    std::vector<RuleProfile> rules;
+};
 
 /**
  * A single context is used for running all active AutoMapper instances on a
@@ -212,8 +303,12 @@ struct TILED_EDITOR_EXPORT AutoMappingContext
     // Clones of existing tile layers that might have been changed in AutoMapper::autoMap
     std::unordered_map<TileLayer*, std::unique_ptr<TileLayer>> originalToOutputLayerMapping;
 
-    // Used to keep track of touched tile layers (only when initially non-empty)
-    QVector<const TileLayer*> touchedTileLayers;
+    // Regions in which the output tile layers may have been changed by
+    // AutoMapper::autoMap, relative to the layers
+    QHash<const TileLayer*, QRegion> changedRegions;
+
+    // When set, AutoMapper::autoMap adds its profiling statistics here
+    std::vector<RulesMapProfile> *profiles = nullptr;
 
 private:
     friend class AutoMapper;
@@ -275,6 +370,12 @@ public:
          * interactive automapping.
          */
         int autoMappingRadius = 0;
+
+        /**
+         * When non-zero, the random decisions are derived from this seed and
+         * the location of each match, so that the result is reproducible.
+         */
+        int randomSeed = 0;
     };
 
     using GetCell = std::add_pointer_t<const Cell &(int x, int y, const TileLayer &tileLayer)>;
@@ -310,12 +411,8 @@ public:
 
     /**
      * Here is done all the AutoMapping.
-     *
-     * When an \a appliedRegion is provided, it is set to the region where
-     * rule outputs have been applied.
      */
     void autoMap(const QRegion &where,
-                 QRegion *appliedRegion,
                  AutoMappingContext &context) const;
 
     /**
@@ -336,6 +433,43 @@ private:
         RuleOptions options;
     };
 
+    /**
+     * The rules compiled for matching, which depend only on the rules map
+     * (including its tilesets, which may get replaced by the ones used by
+     * the target map) and on which of the input layers are present in the
+     * target map.
+     */
+    struct CompiledRules
+    {
+        QVector<SharedTileset> rulesMapTilesets;
+        QVector<bool> inputLayersPresent;
+        std::vector<QVector<RuleInputSet>> ruleInputSets;   // one per rule
+        RuleCellIds cellIds;
+    };
+
+    /**
+     * A band of rows of the region in which a rule is matched. These are the
+     * units of work when matching rules in parallel.
+     */
+    struct MatchBand
+    {
+        size_t ruleIndex;
+        int startX;
+        int startY;
+        int right;
+        int bottom;
+    };
+
+    /**
+     * The result of matching a MatchBand.
+     */
+    struct BandMatches
+    {
+        QVector<QPoint> positions;
+        qint64 positionsTested = 0;
+        qint64 time = 0;            // in nanoseconds
+    };
+
     void setupRuleMapProperties();
     void setupInputLayerProperties(InputLayer &inputLayer);
     void setupOutputSetProperties(OutputSet &outputSet);
@@ -350,14 +484,17 @@ private:
     void setupRules();
 
     void setupWorkMapLayers(AutoMappingContext &context) const;
+    QVector<const TileLayer*> targetInputLayers(const AutoMappingContext &context) const;
+    std::shared_ptr<const CompiledRules> compiledRules(const QVector<const TileLayer*> &inputLayers) const;
     void compileRule(QVector<RuleInputSet> &inputSets,
                      const Rule &rule,
-                     const AutoMappingContext &context) const;
+                     const QVector<bool> &inputLayersPresent) const;
+    static void compileLookups(RuleInputSet &inputSet, const RuleCellIds &cellIds);
     bool compileInputSet(RuleInputSet &index,
                          const InputSet &inputSet,
                          const QRegion &inputRegion,
                          CompileContext &compileContext,
-                         const AutoMappingContext &context) const;
+                         const QVector<bool> &inputLayersPresent) const;
 
     /**
      * This copies all tiles from TileLayer \a srcLayer to TileLayer
@@ -393,27 +530,63 @@ private:
      */
     void copyMapRegion(const Rule &rule, QPoint offset,
                        const OutputSet &ruleOutput,
+                       ApplyContext &applyContext,
                        AutoMappingContext &context) const;
 
     /**
-     * This goes through all the positions in \a matchRegion and checks if the
-     * \a rule matches there.
+     * Copies the tile outputs of the \a rule that were collected in the
+     * \a applyContext, in parallel when there are enough of them. The result
+     * is the same as when copying them one by one.
+     */
+    void copyTileOutputs(const Rule &rule,
+                         ApplyContext &applyContext,
+                         const AutoMappingContext &context) const;
+
+    /**
+     * Splits the part of \a matchRegion in which the rule at \a ruleIndex
+     * needs to be matched into row bands, which are appended to \a bands.
+     */
+    void addMatchBands(QVector<MatchBand> &bands,
+                       size_t ruleIndex,
+                       const QRegion &matchRegion,
+                       const AutoMappingContext &context) const;
+
+    /**
+     * This goes through all the positions in the given \a band and checks
+     * if its rule, as found in \a compiledRules, matches there. The
+     * \a inputLayers are the layers in the target map referred to by the
+     * compiled rules.
+     *
+     * When a \a matchIndex is given, only the candidate locations it
+     * provides for the rule are checked.
      *
-     * Calls \a matched for each matching location.
+     * Calls \a matched for each matching location. Returns the number of
+     * locations that were checked.
      */
-    void matchRule(const Rule &rule,
-                   const QRegion &matchRegion,
-                   GetCell getCell,
-                   const std::function<void (QPoint)> &matched,
-                   const AutoMappingContext &context) const;
+    qint64 matchBand(const MatchBand &band,
+                     const CompiledRules &compiledRules,
+                     const QVector<const TileLayer*> &inputLayers,
+                     GetCell getCell,
+                     const MatchIndex *matchIndex,
+                     const std::function<void (QPoint)> &matched) const;
 
     /**
-     * Applies the given \a rule at each of the given \a positions.
+     * Matches all the given \a bands, in parallel when there is enough work.
+     * Returns the matching locations for each band.
+     */
+    QVector<BandMatches> matchBands(const QVector<MatchBand> &bands,
+                                    const CompiledRules &compiledRules,
+                                    const QVector<const TileLayer*> &inputLayers,
+                                    GetCell getCell,
+                                    const MatchIndex *matchIndex) const;
+
+    /**
+     * Applies the rule at \a ruleIndex at the given position \a pos.
      *
-     * Might skip some of the positions to satisfy the NoOverlappingRules
-     * option.
+     * Might skip the position to satisfy the NoOverlappingRules option.
+     * Returns whether the rule was applied.
      */
-    void applyRule(const Rule &rule, QPoint pos, ApplyContext &applyContext,
+    bool applyRule(size_t ruleIndex, QPoint pos, ApplyContext &applyContext,
                    AutoMappingContext &context) const;
 
     void addWarning(const QString &text,
@@ -444,6 +617,18 @@ private:
     QString mError;
     QString mWarning;
 
+    /**
+     * Time taken to set up the rules, in nanoseconds.
+     */
+    qint64 mSetupTime = 0;
+
+    /**
+     * Compiled rules of the last run, re-used as long as the same input layers
+     * are present in the target map.
+     */
+    mutable std::shared_ptr<const CompiledRules> mCompiledRules;
+    mutable QMutex mCompiledRulesMutex;
+
     const TileLayer dummy;  // used in case input layers are missing
 };
 
@@ -38,53 +38,70 @@ using namespace Tiled;
 AutoMapperWrapper::AutoMapperWrapper(MapDocument *mapDocument,
                                      const QVector<AutoMapper *> &autoMappers,
                                      const QRegion &where,
-                                     const TileLayer *touchedLayer)
+                                     const TileLayer *touchedLayer,
+                                     std::vector<RulesMapProfile> *profiles)
     : PaintTileLayer(mapDocument)
 {
     AutoMappingContext context(mapDocument);
+    context.profiles = profiles;
 
     for (const auto autoMapper : autoMappers)
         autoMapper->prepareAutoMap(context);
 
-    // During "AutoMap while drawing", keep track of the touched layers, so we
-    // can skip any rule maps that doesn't have these layers as input entirely.
-    if (touchedLayer)
-        context.touchedTileLayers.append(touchedLayer);
-
-    // use a copy of the region, so each AutoMapper can manipulate it and the
-    // following AutoMappers do see the impact
-    QRegion region(where);
-    QRegion appliedRegion;
-    QRegion *appliedRegionPtr = &appliedRegion;
     const Map *map = mapDocument->map();
-    const QRegion mapRect(0, 0, map->width(), map->height());
-
-    for (const auto autoMapper : autoMappers) {
-        // stop expanding region when it's already the entire fixed-size map
-        if (appliedRegionPtr && (!map->infinite() && (mapRect - region).isEmpty()))
-            appliedRegionPtr = nullptr;
-
-        if (touchedLayer) {
-            if (std::none_of(context.touchedTileLayers.cbegin(),
-                             context.touchedTileLayers.cend(),
-                             [&] (const TileLayer *tileLayer) { return autoMapper->ruleLayerNameUsed(tileLayer->name()); }))
+    const QRect mapRect(0, 0, map->width(), map->height());
+
+    QHash<const TileLayer*, const TileLayer*> outputToOriginalLayer;
+    for (const auto &[original, outputLayer] : context.originalToOutputLayerMapping)
+        outputToOriginalLayer.insert(outputLayer.get(), original);
+
+    // Each AutoMapper only needs to run where any of its input layers changed,
+    // either by the edit that triggered the automapping or by the previous
+    // AutoMappers. When automapping manually, all layers are considered
+    // changed in the given region.
+    //
+    // During "AutoMap while drawing", only the genuinely changed parts of the
+    // output layers are taken into account, since the map was automapped
+    // before the edit.
+    static const TileLayer emptyLayer;
+
+    auto changedInputRegion = [&] (const AutoMapper *autoMapper) {
+        QRegion region;
+
+        if (!touchedLayer || autoMapper->ruleLayerNameUsed(touchedLayer->name()))
+            region = where;
+
+        for (auto it = context.changedRegions.cbegin(), end = context.changedRegions.cend(); it != end; ++it) {
+            const TileLayer *outputLayer = it.key();
+            if (!autoMapper->ruleLayerNameUsed(outputLayer->name()))
                 continue;
+
+            if (touchedLayer) {
+                const TileLayer *original = outputToOriginalLayer.value(outputLayer, &emptyLayer);
+                region |= original->computeDiffRegion(*outputLayer, it.value());
+            } else {
+                region |= it.value();
+            }
         }
 
-        autoMapper->autoMap(region, appliedRegionPtr, context);
+        if (!map->infinite())       // keep within map boundaries
+            region &= mapRect;
 
-        if (appliedRegionPtr) {
-            // expand where with modified area
-            region |= std::exchange(appliedRegion, QRegion());
+        return region;
+    };
 
-            if (!map->infinite())       // but keep within map boundaries
-                region &= mapRect;
-        }
+    for (const auto autoMapper : autoMappers) {
+        const QRegion region = changedInputRegion(autoMapper);
+        if (region.isEmpty())
+            continue;
+
+        autoMapper->autoMap(region, context);
     }
 
     // Apply the changes to existing tile layers
     for (auto& [original, outputLayer] : context.originalToOutputLayerMapping) {
-        const QRegion diffRegion = original->computeDiffRegion(*outputLayer);
+        const QRegion diffRegion = original->computeDiffRegion(*outputLayer,
+                                                               context.changedRegions.value(outputLayer.get()));
         if (!diffRegion.isEmpty()) {
             paint(original, 0, 0, outputLayer.get(),
                   diffRegion.translated(original->position()));
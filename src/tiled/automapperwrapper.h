@@ -25,9 +25,12 @@
 
 #include <QVector>
 
+#include <vector>
+
 namespace Tiled {
 
 class AutoMapper;
+struct RulesMapProfile;
 
 /**
  * This is a wrapper class for applying the changes by one or more AutoMapper
@@ -39,10 +42,15 @@ class AutoMapper;
 class AutoMapperWrapper : public PaintTileLayer
 {
 public:
+    /**
+     * When \a profiles is given, profiling statistics are collected for each
+     * of the \a autoMappers.
+     */
     AutoMapperWrapper(MapDocument *mapDocument,
                       const QVector<AutoMapper*> &autoMappers,
                       const QRegion &where,
-                      const TileLayer *touchedLayer = nullptr);
+                      const TileLayer *touchedLayer = nullptr,
+                      std::vector<RulesMapProfile> *profiles = nullptr);
 };
 
 } // namespace Tiled
@@ -29,8 +29,10 @@
 #include "preferences.h"
 #include "project.h"
 #include "projectmanager.h"
+#include "rulesmapcache.h"
 #include "tilelayer.h"
 
+#include <QDateTime>
 #include <QDir>
 #include <QFileInfo>
 #include <QFileSystemWatcher>
@@ -38,9 +40,12 @@
 #include <QScopedValueRollback>
 #include <QTextStream>
 
+#include <iterator>
+
 using namespace Tiled;
 
 SessionOption<bool> AutomappingManager::automappingWhileDrawing { "automapping.whileDrawing", false };
+SessionOption<bool> AutomappingManager::automappingProfiling { "automapping.profiling", false };
 
 AutomappingManager::AutomappingManager(QObject *parent)
     : QObject(parent)
@@ -104,6 +109,7 @@ void AutomappingManager::autoMapInternal(const QRegion &where,
 {
     mError.clear();
     mWarning.clear();
+    mProfiles.clear();
 
     if (!mMapDocument)
         return;
@@ -117,7 +123,12 @@ void AutomappingManager::autoMapInternal(const QRegion &where,
             return;
         }
 
-        if (loadFile(mRulesFile)) {
+        const bool loaded = loadFile(mRulesFile);
+
+        // Any rule maps shared with the previous rules have been taken over
+        mPreviousRulesMaps.clear();
+
+        if (loaded) {
             mLoaded = true;
         } else {
             emit errorsOccurred(automatic);
@@ -158,11 +169,57 @@ void AutomappingManager::autoMapInternal(const QRegion &where,
             return;
     }
 
-    AutoMapperWrapper *aw = new AutoMapperWrapper(mMapDocument, autoMappers, where, touchedLayer);
+    const bool profiling = mProfilingEnabled || automappingProfiling;
+
+    AutoMapperWrapper *aw = new AutoMapperWrapper(mMapDocument, autoMappers, where, touchedLayer,
+                                                  profiling ? &mProfiles : nullptr);
     aw->setMergeable(automatic);
     aw->setText(tr("Apply AutoMap rules"));
 
     mMapDocument->undoStack()->push(aw);
+
+    if (automappingProfiling)
+        reportProfiles();
+}
+
+void AutomappingManager::reportProfiles() const
+{
+    // Only the slowest rules of each rules map are listed
+    constexpr size_t maxReportedRules = 10;
+
+    auto ms = [] (qint64 nanoseconds) {
+        return QString::number(nanoseconds / 1000000.0, 'f', 2);
+    };
+
+    for (const RulesMapProfile &profile : mProfiles) {
+        INFO(tr("AutoMapping '%1' took %2 ms (setup %3 ms, compile %4 ms)")
+             .arg(profile.rulesMapFileName,
+                  ms(profile.wallTime),
+                  ms(profile.setupTime),
+                  ms(profile.compileTime)));
+
+        std::vector<const RuleProfile*> rules;
+        for (const RuleProfile &rule : profile.rules)
+            if (rule.positionsTested > 0)
+                rules.push_back(&rule);
+
+        std::sort(rules.begin(), rules.end(), [] (const RuleProfile *a, const RuleProfile *b) {
+            return a->matchTime + a->applyTime > b->matchTime + b->applyTime;
+        });
+        if (rules.size() > maxReportedRules)
+            rules.resize(maxReportedRules);
+
+        for (const RuleProfile *rule : rules) {
+            INFO(tr("    Rule at %1,%2: %3 positions tested, %4 matches, %5 applied, %6 ms matching, %7 ms applying")
+                 .arg(QString::number(rule->bounds.x()),
+                      QString::number(rule->bounds.y()),
+                      QString::number(rule->positionsTested),
+                      QString::number(rule->matches),
+                      QString::number(rule->appliedOutputs),
+                      ms(rule->matchTime),
+                      ms(rule->applyTime)));
+        }
+    }
 }
 
 /**
@@ -210,7 +267,7 @@ bool AutomappingManager::loadRulesFile(const QString &filePath)
         return false;
     }
 
-    mWatcher.addPath(filePath);
+    watchFile(filePath);
 
     QTextStream in(&rulesFile);
 
@@ -255,9 +312,9 @@ bool AutomappingManager::loadRulesFile(const QString &filePath)
 bool AutomappingManager::loadRuleMap(const QString &filePath)
 {
     QString errorString;
-    std::unique_ptr<Map> rules { readMap(filePath, &errorString) };
+    std::shared_ptr<const Map> rulesMap = RulesMapCache::instance()->load(filePath, &errorString);
 
-    if (!rules) {
+    if (!rulesMap) {
         QString error = tr("Opening rules map '%1' failed: %2")
                 .arg(filePath, errorString);
         ERROR(error);
@@ -267,13 +324,16 @@ bool AutomappingManager::loadRuleMap(const QString &filePath)
         return false;
     }
 
-    std::unique_ptr<AutoMapper> autoMapper { new AutoMapper(std::move(rules), mMapNameFilter) };
+    // The AutoMapper changes the tilesets of its rules map to match the map
+    // it is applied to, so it needs its own copy of the shared rules map.
+    auto autoMapper = std::make_unique<AutoMapper>(rulesMap->clone(), mMapNameFilter);
+    mRulesMaps.push_back(std::move(rulesMap));
 
     mWarning += autoMapper->warningString();
     const QString error = autoMapper->errorString();
     if (error.isEmpty()) {
         mAutoMappers.push_back(std::move(autoMapper));
-        mWatcher.addPath(filePath);
+        watchFile(filePath);
     } else {
         mError += error;
     }
@@ -281,6 +341,12 @@ bool AutomappingManager::loadRuleMap(const QString &filePath)
     return true;
 }
 
+void AutomappingManager::watchFile(const QString &filePath)
+{
+    mWatcher.addPath(filePath);
+    mLoadedFiles.insert(filePath, QFileInfo(filePath).lastModified());
+}
+
 /**
  * The rules file is determined based on the map location, or taken from the
  * current project if a "rules.txt" file does not exist alongside the map (or
@@ -291,8 +357,10 @@ bool AutomappingManager::loadRuleMap(const QString &filePath)
 void AutomappingManager::setMapDocument(MapDocument *mapDocument, const QString &rulesFile)
 {
     if (mMapDocument != mapDocument) {
-        if (mMapDocument)
+        if (mMapDocument) {
             mMapDocument->disconnect(this);
+            keepDocumentRules();
+        }
 
         mMapDocument = mapDocument;
 
@@ -305,6 +373,77 @@ void AutomappingManager::setMapDocument(MapDocument *mapDocument, const QString
     }
 
     refreshRulesFile(rulesFile);
+
+    if (mMapDocument && !mLoaded)
+        restoreDocumentRules();
+}
+
+/**
+ * Remembers the loaded rules for the current map document, so that they
+ * can be used again along with their compiled rules when switching back to
+ * this document.
+ */
+void AutomappingManager::keepDocumentRules()
+{
+    if (mLoaded) {
+        DocumentRules &documentRules = mDocumentRules[mMapDocument];
+        documentRules.rulesFile = mRulesFile;
+        documentRules.autoMappers = std::move(mAutoMappers);
+        documentRules.rulesMaps = std::move(mRulesMaps);
+        documentRules.files = mLoadedFiles;
+
+        connect(mMapDocument, &QObject::destroyed,
+                this, &AutomappingManager::onDocumentDestroyed);
+    }
+
+    mAutoMappers.clear();
+    mRulesMaps.clear();
+    mLoadedFiles.clear();
+    mLoaded = false;
+}
+
+/**
+ * Restores the rules remembered for the current map document, unless a
+ * different rules file is used by now or any of the files has changed.
+ */
+void AutomappingManager::restoreDocumentRules()
+{
+    auto it = mDocumentRules.find(mMapDocument);
+    if (it == mDocumentRules.end())
+        return;
+
+    DocumentRules documentRules = std::move(it->second);
+    mDocumentRules.erase(it);
+
+    if (documentRules.rulesFile != mRulesFile)
+        return;
+
+    for (auto fileIt = documentRules.files.cbegin(); fileIt != documentRules.files.cend(); ++fileIt)
+        if (QFileInfo(fileIt.key()).lastModified() != fileIt.value())
+            return;
+
+    if (!mWatcher.files().isEmpty())
+        mWatcher.removePaths(mWatcher.files());
+    if (!documentRules.files.isEmpty())
+        mWatcher.addPaths(documentRules.files.keys());
+
+    mAutoMappers = std::move(documentRules.autoMappers);
+    mRulesMaps = std::move(documentRules.rulesMaps);
+    mLoadedFiles = std::move(documentRules.files);
+    mLoaded = true;
+}
+
+void AutomappingManager::onDocumentDestroyed(QObject *document)
+{
+    auto it = mDocumentRules.find(document);
+    if (it == mDocumentRules.end())
+        return;
+
+    // Keep the rule maps around in case the next map uses them as well
+    auto &rulesMaps = it->second.rulesMaps;
+    std::move(rulesMaps.begin(), rulesMaps.end(), std::back_inserter(mPreviousRulesMaps));
+
+    mDocumentRules.erase(it);
 }
 
 /**
@@ -340,13 +479,21 @@ void AutomappingManager::refreshRulesFile(const QString &ruleFileOverride)
 void AutomappingManager::cleanUp()
 {
     mAutoMappers.clear();
+
+    // Keep the rule maps around until the new rules are loaded, since they
+    // may use some of the same rule maps
+    std::move(mRulesMaps.begin(), mRulesMaps.end(), std::back_inserter(mPreviousRulesMaps));
+    mRulesMaps.clear();
+
+    mLoadedFiles.clear();
     mLoaded = false;
     if (!mWatcher.files().isEmpty())
         mWatcher.removePaths(mWatcher.files());
 }
 
-void AutomappingManager::onFileChanged()
+void AutomappingManager::onFileChanged(const QString &path)
 {
+    RulesMapCache::instance()->remove(path);
     cleanUp();
 }
 
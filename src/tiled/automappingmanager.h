@@ -23,12 +23,15 @@
 
 #include "session.h"
 
+#include <QDateTime>
 #include <QFileSystemWatcher>
+#include <QHash>
 #include <QObject>
 #include <QRegion>
 #include <QRegularExpression>
 #include <QString>
 
+#include <map>
 #include <memory>
 #include <vector>
 
@@ -37,7 +40,9 @@ namespace Tiled {
 class TileLayer;
 
 class AutoMapper;
+class Map;
 class MapDocument;
+struct RulesMapProfile;
 
 /**
  * This class is a superior class to the AutoMapper and AutoMapperWrapper class.
@@ -66,7 +71,19 @@ public:
     void autoMap();
     void autoMapRegion(const QRegion &region);
 
+    /**
+     * Enables collecting profiling statistics for each AutoMapping run,
+     * which are available from profiles() afterwards.
+     */
+    void setProfilingEnabled(bool enabled) { mProfilingEnabled = enabled; }
+
+    /**
+     * Returns the profiling statistics of the last AutoMapping run.
+     */
+    const std::vector<RulesMapProfile> &profiles() const { return mProfiles; }
+
     static SessionOption<bool> automappingWhileDrawing;
+    static SessionOption<bool> automappingProfiling;
 
 signals:
     /**
@@ -82,11 +99,16 @@ signals:
 private:
     void onRegionEdited(const QRegion &where, TileLayer *touchedLayer);
     void onMapFileNameChanged();
-    void onFileChanged();
+    void onFileChanged(const QString &path);
+    void onDocumentDestroyed(QObject *document);
 
     bool loadFile(const QString &filePath);
     bool loadRulesFile(const QString &filePath);
     bool loadRuleMap(const QString &filePath);
+    void watchFile(const QString &filePath);
+
+    void keepDocumentRules();
+    void restoreDocumentRules();
 
     /**
      * Applies automapping to the region \a where.
@@ -96,6 +118,11 @@ private:
      */
     void autoMapInternal(const QRegion &where, const TileLayer *touchedLayer);
 
+    /**
+     * Reports the statistics of the last AutoMapping run in the Console.
+     */
+    void reportProfiles() const;
+
     /**
      * deletes all its data structures
      */
@@ -109,9 +136,48 @@ private:
     /**
      * For each new file of rules a new AutoMapper is setup. In this vector we
      * can store all of the AutoMappers in order.
+     *
+     * Each AutoMapper works on its own copy of the rule map, since it adjusts
+     * the tilesets of its rule map to the current map document.
      */
     std::vector<std::unique_ptr<AutoMapper>> mAutoMappers;
 
+    /**
+     * The rule maps as shared by the RulesMapCache, which are kept alive
+     * while they are in use by the AutoMappers.
+     */
+    std::vector<std::shared_ptr<const Map>> mRulesMaps;
+
+    /**
+     * The rule maps that were in use before the rules were cleaned up. They
+     * are kept until the rules are loaded again, to avoid reloading the rule
+     * maps that are still used.
+     */
+    std::vector<std::shared_ptr<const Map>> mPreviousRulesMaps;
+
+    /**
+     * The rule files and rule maps that were loaded, along with their last
+     * modification time.
+     */
+    QHash<QString, QDateTime> mLoadedFiles;
+
+    /**
+     * The loaded rules of a map document that is not the current one.
+     */
+    struct DocumentRules
+    {
+        QString rulesFile;
+        std::vector<std::unique_ptr<AutoMapper>> autoMappers;
+        std::vector<std::shared_ptr<const Map>> rulesMaps;
+        QHash<QString, QDateTime> files;
+    };
+
+    /**
+     * Keeps the loaded rules of other map documents, so that switching
+     * between documents does not need to load and compile the rules again.
+     */
+    std::map<const QObject*, DocumentRules> mDocumentRules;
+
     /**
      * This tells you if the rules for the current map document were already
      * loaded.
@@ -132,6 +198,9 @@ private:
 
     QFileSystemWatcher mWatcher;
 
+    bool mProfilingEnabled = false;
+    std::vector<RulesMapProfile> mProfiles;
+
     QString mRulesFile;
     QRegularExpression mMapNameFilter;
     bool mRulesFileOverride = false;
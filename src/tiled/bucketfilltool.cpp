@@ -51,6 +51,14 @@ BucketFillTool::~BucketFillTool()
 {
 }
 
+void BucketFillTool::mapDocumentChanged(MapDocument *oldDocument,
+                                        MapDocument *newDocument)
+{
+    AbstractTileFillTool::mapDocumentChanged(oldDocument, newDocument);
+
+    mFillRegionCache.setMapDocument(newDocument);
+}
+
 void BucketFillTool::tilePositionChanged(QPoint tilePos)
 {
     AbstractTileFillTool::tilePositionChanged(tilePos);
@@ -103,7 +111,7 @@ void BucketFillTool::tilePositionChanged(QPoint tilePos)
             }
 
             if (computeRegion)
-                mFillRegion = regionComputer.computePaintableFillRegion(tilePos);
+                mFillRegion = mFillRegionCache.paintableFillRegion(tileLayer, tilePos);
             else
                 mFillRegion = QRegion();
         } else {
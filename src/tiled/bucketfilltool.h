@@ -23,6 +23,7 @@
 #pragma once
 
 #include "abstracttilefilltool.h"
+#include "fillregioncache.h"
 #include "tilelayer.h"
 #include "tilestamp.h"
 
@@ -52,6 +53,9 @@ public:
     void languageChanged() override;
 
 protected:
+    void mapDocumentChanged(MapDocument *oldDocument,
+                            MapDocument *newDocument) override;
+
     void tilePositionChanged(QPoint tilePos) override;
     void clearConnections(MapDocument *mapDocument) override;
 
@@ -70,6 +74,7 @@ private:
     FillMethod mLastFillMethod;
 
     QRegion mFillRegion;
+    FillRegionCache mFillRegionCache;
 
     void makeConnections();
 };
@@ -27,6 +27,7 @@
 #include "object.h"
 #include "tile.h"
 #include "undocommands.h"
+#include "undomemorylimiter.h"
 #include "wangset.h"
 
 #include <QFileInfo>
@@ -49,6 +50,8 @@ Document::Document(DocumentType type, const QString &fileName,
 
     connect(mUndoStack, &QUndoStack::indexChanged, this, &Document::updateIsModified);
     connect(mUndoStack, &QUndoStack::cleanChanged, this, &Document::updateIsModified);
+
+    new UndoMemoryLimiter(mUndoStack);
 }
 
 Document::~Document()
@@ -22,6 +22,7 @@
 
 #include "addremovetileset.h"
 #include "changelayer.h"
+#include "connectedcomponents.h"
 #include "editablemanager.h"
 #include "editablemap.h"
 #include "painttilelayer.h"
@@ -78,6 +79,45 @@ RegionValueType EditableTileLayer::region() const
     return RegionValueType(tileLayer()->region());
 }
 
+/**
+ * Returns the connected areas of equal cells, in the order in which they are
+ * first encountered scanning the rows from top to bottom.
+ *
+ * On staggered and hexagonal maps the adjacency of the map is used, otherwise
+ * \a diagonal determines whether cells touching at a corner are connected.
+ */
+QVector<RegionValueType> EditableTileLayer::connectedRegions(bool diagonal) const
+{
+    const TileLayer *layer = tileLayer();
+    const Map *map = layer->map();
+
+    const QRect bounds = map && map->infinite() ? layer->localBounds()
+                                                : QRect(QPoint(), layer->size());
+
+    auto connectivity = diagonal ? ConnectedComponents::EightWay
+                                 : ConnectedComponents::FourWay;
+    auto staggerAxis = Map::StaggerY;
+    auto staggerIndex = Map::StaggerOdd;
+
+    if (map && ConnectedComponents::connectivityFor(map) == ConnectedComponents::Staggered) {
+        connectivity = ConnectedComponents::Staggered;
+        staggerAxis = map->staggerAxis();
+        staggerIndex = map->staggerIndex();
+    }
+
+    const ConnectedComponents components(*layer, bounds, connectivity,
+                                         staggerAxis, staggerIndex);
+
+    QVector<RegionValueType> regions;
+    regions.reserve(components.count());
+
+    const auto componentRegions = components.regions();
+    for (const QRegion &region : componentRegions)
+        regions.append(RegionValueType(region.translated(layer->position())));
+
+    return regions;
+}
+
 Cell EditableTileLayer::cellAt(int x, int y) const
 {
     return tileLayer()->cellAt(x, y);
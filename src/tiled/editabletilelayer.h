@@ -63,6 +63,7 @@ public:
     Q_INVOKABLE void resize(QSize size, QPoint offset = QPoint());
 
     Q_INVOKABLE Tiled::RegionValueType region() const;
+    Q_INVOKABLE QVector<Tiled::RegionValueType> connectedRegions(bool diagonal = false) const;
 
     Q_INVOKABLE Tiled::Cell cellAt(int x, int y) const;
     Q_INVOKABLE int flagsAt(int x, int y) const;
@@ -0,0 +1,243 @@
+/*
+ * fillregioncache.cpp
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "fillregioncache.h"
+
+#include "mapdocument.h"
+#include "tilelayer.h"
+#include "tilepainter.h"
+
+#include <QtConcurrent>
+
+#include <memory>
+
+using namespace Tiled;
+
+static constexpr int maximumRecentRegions = 8;
+static constexpr int maximumLabeledRegions = 64;
+
+// Labels take 4 bytes per cell, so they are skipped for very large layers
+static constexpr qint64 maximumLabeledArea = 4096 * 4096;
+
+FillRegionCache::FillRegionCache(QObject *parent)
+    : QObject(parent)
+{
+    connect(&mLabelsWatcher, &QFutureWatcher<ConnectedComponents>::finished,
+            this, &FillRegionCache::labelsComputed);
+}
+
+FillRegionCache::~FillRegionCache()
+{
+    ++mGeneration;      // makes a running labeling task stop early
+    mLabelsWatcher.waitForFinished();
+}
+
+void FillRegionCache::setMapDocument(MapDocument *mapDocument)
+{
+    if (mMapDocument == mapDocument)
+        return;
+
+    if (mMapDocument)
+        mMapDocument->disconnect(this);
+
+    mMapDocument = mapDocument;
+    clear();
+
+    if (mapDocument) {
+        connect(mapDocument, &MapDocument::regionChanged,
+                this, [this] (const QRegion &, TileLayer *tileLayer) { layerChanged(tileLayer); });
+        connect(mapDocument, &MapDocument::tileLayerChanged,
+                this, [this] (TileLayer *tileLayer) { layerChanged(tileLayer); });
+        connect(mapDocument, &MapDocument::layerRemoved,
+                this, &FillRegionCache::layerRemoved);
+    }
+}
+
+/**
+ * Returns the region of cells connected to \a fillOrigin, like
+ * TilePainter::computeFillRegion.
+ */
+QRegion FillRegionCache::fillRegion(TileLayer *tileLayer, QPoint fillOrigin)
+{
+    validate(tileLayer);
+
+    // Once the labels are available, regions are found by their label
+    const int label = mLabels.labelAt(fillOrigin - tileLayer->position());
+    if (label != -1) {
+        const auto it = mLabeledRegions.constFind(label);
+        if (it != mLabeledRegions.constEnd())
+            return it.value();
+    }
+
+    // The regions are disjoint, so any region containing the origin is the
+    // region that would be computed
+    QRegion region;
+
+    for (int i = 0; i < mRecentRegions.size(); ++i) {
+        if (mRecentRegions.at(i).contains(fillOrigin)) {
+            mRecentRegions.move(i, 0);
+            region = mRecentRegions.first();
+            break;
+        }
+    }
+
+    if (region.isEmpty()) {
+        region = TilePainter(mMapDocument, tileLayer).computeFillRegion(fillOrigin);
+        if (region.isEmpty())
+            return region;
+
+        mRecentRegions.prepend(region);
+        if (mRecentRegions.size() > maximumRecentRegions)
+            mRecentRegions.removeLast();
+    }
+
+    if (label != -1) {
+        if (mLabeledRegions.size() >= maximumLabeledRegions)
+            mLabeledRegions.clear();
+        mLabeledRegions.insert(label, region);
+    } else {
+        startLabeling();
+    }
+
+    return region;
+}
+
+/**
+ * Returns the region of cells connected to \a fillOrigin that can be painted,
+ * like TilePainter::computePaintableFillRegion.
+ */
+QRegion FillRegionCache::paintableFillRegion(TileLayer *tileLayer, QPoint fillOrigin)
+{
+    const QRegion &selection = mMapDocument->selectedArea();
+
+    // Unless on an infinite map with a selection, the paintable region is
+    // the connected region limited to the selection.
+    if (selection.isEmpty() || !mMapDocument->map()->infinite()) {
+        QRegion region = fillRegion(tileLayer, fillOrigin);
+        if (!selection.isEmpty())
+            region &= selection;
+        return region;
+    }
+
+    // Otherwise the search is bounded by the selection, so only the last
+    // region is remembered.
+    validate(tileLayer);
+
+    if (mPaintableSelection != selection || !mPaintableRegion.contains(fillOrigin)) {
+        mPaintableRegion = TilePainter(mMapDocument, tileLayer).computePaintableFillRegion(fillOrigin);
+        mPaintableSelection = selection;
+    }
+
+    return mPaintableRegion;
+}
+
+void FillRegionCache::clear()
+{
+    ++mGeneration;
+
+    mTileLayer = nullptr;
+    mRecentRegions.clear();
+    mLabels = ConnectedComponents();
+    mLabeledRegions.clear();
+    mPaintableRegion = QRegion();
+    mPaintableSelection = QRegion();
+}
+
+void FillRegionCache::layerChanged(TileLayer *tileLayer)
+{
+    if (tileLayer == mTileLayer)
+        clear();
+}
+
+void FillRegionCache::layerRemoved(Layer *)
+{
+    // The layer may also have been removed as part of a group
+    clear();
+}
+
+/**
+ * Clears the cache when it was not computed for the given \a tileLayer in
+ * its current state.
+ */
+void FillRegionCache::validate(TileLayer *tileLayer)
+{
+    const Map *map = mMapDocument->map();
+
+    if (mTileLayer == tileLayer &&
+            mLayerRect == tileLayer->rect() &&
+            mLayerBounds == tileLayer->bounds() &&
+            mOrientation == map->orientation() &&
+            mStaggerAxis == map->staggerAxis() &&
+            mStaggerIndex == map->staggerIndex())
+        return;
+
+    clear();
+
+    mTileLayer = tileLayer;
+    mLayerRect = tileLayer->rect();
+    mLayerBounds = tileLayer->bounds();
+    mOrientation = map->orientation();
+    mStaggerAxis = map->staggerAxis();
+    mStaggerIndex = map->staggerIndex();
+}
+
+/**
+ * Starts labeling the connected components of the current layer in a
+ * background thread, based on a snapshot of the layer.
+ */
+void FillRegionCache::startLabeling()
+{
+    if (!mTileLayer || mLabels.count() > 0 || mLabelsWatcher.isRunning())
+        return;
+
+    // Use the same bounds as TilePainter::computeFillRegion
+    const QRect bounds = (mMapDocument->map()->infinite() ? mLayerBounds : mLayerRect)
+            .translated(-mTileLayer->position());
+
+    if (bounds.isEmpty() || qint64(bounds.width()) * bounds.height() > maximumLabeledArea)
+        return;
+
+    const std::shared_ptr<const TileLayer> layer(mTileLayer->clone());
+    const auto connectivity = ConnectedComponents::connectivityFor(mMapDocument->map());
+    const auto staggerAxis = mStaggerAxis;
+    const auto staggerIndex = mStaggerIndex;
+    const int generation = mGeneration;
+    const std::atomic<int> *currentGeneration = &mGeneration;
+
+    mLabelingGeneration = generation;
+    mLabelsWatcher.setFuture(QtConcurrent::run([=] {
+        // Stop early when the result is no longer needed
+        return ConnectedComponents(*layer, bounds, connectivity, staggerAxis, staggerIndex,
+                                   [=] { return *currentGeneration != generation; });
+    }));
+}
+
+void FillRegionCache::labelsComputed()
+{
+    // Start again when the layer changed while labeling
+    if (mLabelingGeneration != mGeneration) {
+        startLabeling();
+        return;
+    }
+
+    mLabels = mLabelsWatcher.result();
+}
+
+#include "moc_fillregioncache.cpp"
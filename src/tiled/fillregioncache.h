@@ -0,0 +1,95 @@
+/*
+ * fillregioncache.h
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "connectedcomponents.h"
+#include "map.h"
+
+#include <QFutureWatcher>
+#include <QHash>
+#include <QObject>
+#include <QRegion>
+#include <QVector>
+
+#include <atomic>
+
+namespace Tiled {
+
+class Layer;
+class MapDocument;
+class TileLayer;
+
+/**
+ * Caches the regions of connected cells computed by the fill tools.
+ *
+ * Recently computed regions are remembered, so moving the mouse within the
+ * same area does not compute the region again. In addition, a map labeling
+ * the connected components of the layer is computed in the background, which
+ * is used to look up previously computed regions directly.
+ *
+ * The cache is cleared whenever the layer changes.
+ */
+class FillRegionCache : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit FillRegionCache(QObject *parent = nullptr);
+    ~FillRegionCache() override;
+
+    void setMapDocument(MapDocument *mapDocument);
+
+    QRegion fillRegion(TileLayer *tileLayer, QPoint fillOrigin);
+    QRegion paintableFillRegion(TileLayer *tileLayer, QPoint fillOrigin);
+
+    void clear();
+
+private:
+    void layerChanged(TileLayer *tileLayer);
+    void layerRemoved(Layer *layer);
+    void labelsComputed();
+
+    void validate(TileLayer *tileLayer);
+    void startLabeling();
+
+    MapDocument *mMapDocument = nullptr;
+
+    // The state for which the cached regions are valid
+    TileLayer *mTileLayer = nullptr;
+    QRect mLayerRect;
+    QRect mLayerBounds;
+    Map::Orientation mOrientation = Map::Unknown;
+    Map::StaggerAxis mStaggerAxis = Map::StaggerY;
+    Map::StaggerIndex mStaggerIndex = Map::StaggerOdd;
+
+    QVector<QRegion> mRecentRegions;    // most recently used first
+    ConnectedComponents mLabels;
+    QHash<int, QRegion> mLabeledRegions;
+
+    QRegion mPaintableRegion;
+    QRegion mPaintableSelection;
+
+    QFutureWatcher<ConnectedComponents> mLabelsWatcher;
+    std::atomic<int> mGeneration { 0 };
+    int mLabelingGeneration = 0;
+};
+
+} // namespace Tiled
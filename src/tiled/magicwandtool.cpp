@@ -24,7 +24,6 @@
 #include "magicwandtool.h"
 
 #include "brushitem.h"
-#include "tilepainter.h"
 
 using namespace Tiled;
 
@@ -38,6 +37,14 @@ MagicWandTool::MagicWandTool(QObject *parent)
 {
 }
 
+void MagicWandTool::mapDocumentChanged(MapDocument *oldDocument,
+                                       MapDocument *newDocument)
+{
+    AbstractTileSelectionTool::mapDocumentChanged(oldDocument, newDocument);
+
+    mFillRegionCache.setMapDocument(newDocument);
+}
+
 void MagicWandTool::tilePositionChanged(QPoint tilePos)
 {
     // Make sure that a tile layer is selected
@@ -45,8 +52,7 @@ void MagicWandTool::tilePositionChanged(QPoint tilePos)
     if (!tileLayer)
         return;
 
-    TilePainter regionComputer(mapDocument(), tileLayer);
-    setSelectedRegion(regionComputer.computeFillRegion(tilePos));
+    setSelectedRegion(mFillRegionCache.fillRegion(tileLayer, tilePos));
     brushItem()->setTileRegion(selectedRegion());
 }
 
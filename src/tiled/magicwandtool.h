@@ -25,6 +25,7 @@
 
 
 #include "abstracttileselectiontool.h"
+#include "fillregioncache.h"
 
 #include "tilelayer.h"
 
@@ -45,7 +46,13 @@ public:
     void languageChanged() override;
 
 protected:
+    void mapDocumentChanged(MapDocument *oldDocument,
+                            MapDocument *newDocument) override;
+
     void tilePositionChanged(QPoint tilePos) override;
+
+private:
+    FillRegionCache mFillRegionCache;
 };
 
 } // namespace Tiled
@@ -250,6 +250,7 @@ MainWindow::MainWindow(QWidget *parent, Qt::WindowFlags flags)
     ActionManager::registerAction(mUi->actionAddAutomappingRulesTileset, "AddAutomappingRulesTileset");
     ActionManager::registerAction(mUi->actionAddFolderToProject, "AddFolderToProject");
     ActionManager::registerAction(mUi->actionAutoMap, "AutoMap");
+    ActionManager::registerAction(mUi->actionAutoMapProfiling, "AutoMapProfiling");
     ActionManager::registerAction(mUi->actionAutoMapWhileDrawing, "AutoMapWhileDrawing");
     ActionManager::registerAction(mUi->actionClearRecentFiles, "ClearRecentFiles");
     ActionManager::registerAction(mUi->actionClearRecentProjects, "ClearRecentProjects");
@@ -437,6 +438,7 @@ MainWindow::MainWindow(QWidget *parent, Qt::WindowFlags flags)
     mUi->actionHighlightHoveredObject->setChecked(preferences->highlightHoveredObject());
 
     bindToOption(mUi->actionAutoMapWhileDrawing, AutomappingManager::automappingWhileDrawing);
+    bindToOption(mUi->actionAutoMapProfiling, AutomappingManager::automappingProfiling);
     bindToOption(mUi->actionEnableWorlds, MapScene::enableWorlds);
 
     mUi->actionHighlightCurrentLayer->setIcon(highlightCurrentLayerIcon);
@@ -67,6 +67,8 @@
 #include <QString>
 #include <QUndoStack>
 
+#include <utility>
+
 using namespace Tiled;
 
 MapDocument::MapDocument(std::unique_ptr<Map> map)
@@ -95,6 +97,10 @@ MapDocument::MapDocument(std::unique_ptr<Map> map)
     connect(mLayerModel, &LayerModel::layerRemoved,
             this, &MapDocument::onLayerRemoved);
 
+    // Coalesce tile changes for emitting regionsChanged
+    connect(this, &MapDocument::regionChanged,
+            this, &MapDocument::collectChangedRegion);
+
     // Forward signals emitted from the map object model
     mMapObjectModel->setMapDocument(this);
     connect(this, &Document::changed,
@@ -1472,6 +1478,32 @@ void MapDocument::onLayerAboutToBeRemoved(GroupLayer *groupLayer, int index)
     emit layerAboutToBeRemoved(groupLayer, index);
 }
 
+void MapDocument::collectChangedRegion(const QRegion &region, TileLayer *tileLayer)
+{
+    if (region.isEmpty())
+        return;
+
+    // Schedule emitting the changes when the first change comes in
+    if (mChangedRegions.isEmpty())
+        QMetaObject::invokeMethod(this, &MapDocument::emitChangedRegions, Qt::QueuedConnection);
+
+    mChangedRegions[tileLayer] |= region;
+}
+
+void MapDocument::emitChangedRegions()
+{
+    const auto changedRegions = std::exchange(mChangedRegions, {});
+
+    // Only look up layers still part of the map, since others may have been
+    // deleted in the meantime.
+    LayerIterator iterator(mMap.get(), Layer::TileLayerType);
+    while (auto tileLayer = static_cast<TileLayer*>(iterator.next())) {
+        const auto it = changedRegions.constFind(tileLayer);
+        if (it != changedRegions.constEnd())
+            emit regionsChanged(it.value(), tileLayer);
+    }
+}
+
 void MapDocument::onLayerRemoved(Layer *layer)
 {
     if (mCurrentLayer && mCurrentLayer->isParentOrSelf(layer)) {
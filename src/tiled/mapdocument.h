@@ -338,6 +338,16 @@ signals:
      */
     void regionChanged(const QRegion &region, TileLayer *tileLayer);
 
+    /**
+     * Emitted once per event loop iteration for each tile layer that changed,
+     * with the union of the regions reported by regionChanged in the
+     * meantime. Suitable for updating views, since a bulk edit may emit
+     * regionChanged many times.
+     *
+     * Not emitted for layers that were removed from the map in the meantime.
+     */
+    void regionsChanged(const QRegion &region, TileLayer *tileLayer);
+
     /**
      * Emitted when a certain \a region of the map was edited by user input.
      * The region is given in tile coordinates.
@@ -387,6 +397,9 @@ private:
     void onLayerAboutToBeRemoved(GroupLayer *groupLayer, int index);
     void onLayerRemoved(Layer *layer);
 
+    void collectChangedRegion(const QRegion &region, TileLayer *tileLayer);
+    void emitChangedRegions();
+
     void moveObjectIndex(const MapObject *object, int count);
 
     QString newLayerName(Layer::TypeFlag layerType) const;
@@ -409,6 +422,8 @@ private:
     MapObjectModel *mMapObjectModel;
     bool mAllowHidingObjects = true;
     bool mAllowTileObjects = true;
+
+    QHash<TileLayer*, QRegion> mChangedRegions;
 };
 
 } // namespace Tiled
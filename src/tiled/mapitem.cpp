@@ -38,6 +38,7 @@
 #include "tilelayer.h"
 #include "tilelayeritem.h"
 #include "tileselectionitem.h"
+#include "tintedpixmapcache.h"
 #include "worldmanager.h"
 #include "zoomable.h"
 
@@ -154,7 +155,7 @@ MapItem::MapItem(const MapDocumentPtr &mapDocument, DisplayMode displayMode,
 
     connect(mapDocument.data(), &Document::changed, this, &MapItem::documentChanged);
     connect(mapDocument.data(), &MapDocument::mapChanged, this, &MapItem::mapChanged);
-    connect(mapDocument.data(), &MapDocument::regionChanged, this, &MapItem::repaintRegion);
+    connect(mapDocument.data(), &MapDocument::regionsChanged, this, &MapItem::repaintRegion);
     connect(mapDocument.data(), &MapDocument::tileLayerChanged, this, &MapItem::tileLayerChanged);
     connect(mapDocument.data(), &MapDocument::layerAdded, this, &MapItem::layerAdded);
     connect(mapDocument.data(), &MapDocument::layerAboutToBeRemoved, this, &MapItem::layerAboutToBeRemoved);
@@ -204,6 +205,8 @@ MapItem::MapItem(const MapDocumentPtr &mapDocument, DisplayMode displayMode,
 
 MapItem::~MapItem()
 {
+    for (const QColor &color : std::as_const(mPinnedTintColors))
+        TintedPixmapCache::unpinColor(color);
 }
 
 void MapItem::setDisplayMode(DisplayMode displayMode)
@@ -347,6 +350,7 @@ void MapItem::repaintRegion(const QRegion &region, TileLayer *tileLayer)
     const MapRenderer *renderer = mapDocument()->renderer();
     const QMargins margins = mapDocument()->map()->drawMargins();
     TileLayerItem *tileLayerItem = static_cast<TileLayerItem*>(mLayerItems.value(tileLayer));
+    tileLayerItem->invalidateRegion(region);
 
     for (const QRect &r : region) {
         QRectF boundingRect = renderer->boundingRect(r).marginsAdded(margins);
@@ -414,8 +418,9 @@ void MapItem::documentChanged(const ChangeEvent &change)
     }
     case ChangeEvent::TilesetChanged: {
         auto &tilesetChange = static_cast<const TilesetChangeEvent&>(change);
-        if (tilesetChange.property == Tileset::TileRenderSizeProperty) {
-            // This might affect the draw margins
+        if (tilesetChange.property == Tileset::TileRenderSizeProperty ||
+                tilesetChange.property == Tileset::FillModeProperty) {
+            // This might affect the draw margins and the tile geometry
             for (QGraphicsItem *item : std::as_const(mLayerItems)) {
                 if (TileLayerItem *tli = dynamic_cast<TileLayerItem*>(item))
                     tli->syncWithTileLayer();
@@ -510,6 +515,8 @@ void MapItem::layerChanged(const LayerChangeEvent &change)
 
     if (change.properties & LayerChangeEvent::TintColorProperty)
         layerTintColorChanged(layer);
+    else if (change.properties & LayerChangeEvent::VisibleProperty)
+        updatePinnedTintColors(layer);
 
     layerItem->setVisible(layer->isVisible());
 
@@ -561,8 +568,37 @@ void MapItem::layerTintColorChanged(Layer *layer)
         // Recurse into group layers since tint color is inherited
         for (auto childLayer : static_cast<GroupLayer*>(layer)->layers())
             layerTintColorChanged(childLayer);
-        break;
+        return;
+    }
+
+    updatePinnedTintColors(layer);
+}
+
+/**
+ * Pins the tint color of the given \a layer (or of its child layers) in the
+ * TintedPixmapCache while the layer is visible, so that its tinted tileset
+ * images are not evicted by those of other layers.
+ */
+void MapItem::updatePinnedTintColors(Layer *layer)
+{
+    if (GroupLayer *groupLayer = layer->asGroupLayer()) {
+        for (auto childLayer : groupLayer->layers())
+            updatePinnedTintColors(childLayer);
+        return;
     }
+
+    const QColor color = layer->isHidden() ? QColor() : layer->effectiveTintColor();
+    const QColor previousColor = mPinnedTintColors.value(layer);
+    if (color == previousColor)
+        return;
+
+    TintedPixmapCache::unpinColor(previousColor);
+    TintedPixmapCache::pinColor(color);
+
+    if (color.isValid())
+        mPinnedTintColors.insert(layer, color);
+    else
+        mPinnedTintColors.remove(layer);
 }
 
 /**
@@ -785,6 +821,8 @@ LayerItem *MapItem::createLayerItem(Layer *layer)
 
     if (GroupLayer *groupLayer = layer->asGroupLayer())
         createLayerItems(groupLayer->layers());
+    else
+        updatePinnedTintColors(layer);
 
     return layerItem;
 }
@@ -807,6 +845,7 @@ void MapItem::deleteLayerItems(Layer *layer)
         break;
     }
 
+    TintedPixmapCache::unpinColor(mPinnedTintColors.take(layer));
     delete mLayerItems.take(layer);
 }
 
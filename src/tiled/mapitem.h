@@ -108,6 +108,7 @@ private:
     void layerRemoved(Layer *layer);
     void layerChanged(const LayerChangeEvent &change);
     void layerTintColorChanged(Layer *layer);
+    void updatePinnedTintColors(Layer *layer);
 
     void imageLayerChanged(ImageLayer *imageLayer);
 
@@ -142,6 +143,7 @@ private:
     std::unique_ptr<ObjectSelectionItem> mObjectSelectionItem;
     QMap<Layer*, LayerItem*> mLayerItems;
     QMap<MapObject*, MapObjectItem*> mObjectItems;
+    QMap<Layer*, QColor> mPinnedTintColors;
     DisplayMode mDisplayMode;
     QRectF mBoundingRect;
     bool mIsHovered = false;
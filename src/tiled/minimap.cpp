@@ -43,6 +43,7 @@ MiniMap::MiniMap(QWidget *parent)
     , mDragging(false)
     , mMouseMoveCursorState(false)
     , mRedrawMapImage(false)
+    , mRegionChangedSinceIndexChange(false)
     , mRenderFlags(MiniMapRenderer::DrawTileLayers
                    | MiniMapRenderer::DrawMapObjects
                    | MiniMapRenderer::DrawImageLayers
@@ -66,15 +67,26 @@ void MiniMap::setMapDocument(MapDocument *map)
 
     if (mMapDocument) {
         mMapDocument->disconnect(this);
+        mMapDocument->undoStack()->disconnect(this);
 
         if (MapView *mapView = dm->viewForDocument(mMapDocument))
             mapView->disconnect(this);
     }
 
     mMapDocument = map;
+    mDirtyRect = QRect();
+    mRegionChangedSinceIndexChange = false;
 
     if (mMapDocument) {
         connect(mMapDocument->undoStack(), &QUndoStack::indexChanged,
+                this, &MiniMap::undoIndexChanged);
+        connect(mMapDocument, &MapDocument::regionChanged,
+                this, [this] { mRegionChangedSinceIndexChange = true; });
+        connect(mMapDocument, &MapDocument::regionsChanged,
+                this, &MiniMap::regionChanged);
+        connect(mMapDocument, &Document::changed,
+                this, &MiniMap::scheduleMapImageUpdate);
+        connect(mMapDocument, &MapDocument::tileLayerChanged,
                 this, &MiniMap::scheduleMapImageUpdate);
 
         if (MapView *mapView = dm->viewForDocument(mMapDocument))
@@ -101,6 +113,8 @@ void MiniMap::paintEvent(QPaintEvent *pe)
     if (mRedrawMapImage) {
         renderMapToImage();
         mRedrawMapImage = false;
+    } else if (!mDirtyRect.isEmpty()) {
+        renderDirtyRect();
     }
 
     if (mMapImage.isNull() || mImageRect.isEmpty())
@@ -155,8 +169,17 @@ void MiniMap::updateImageRect()
     mImageRect = imageRect;
 }
 
+/**
+ * Renders the whole map into the minimap image. This is throttled by the
+ * update timer, while tile changes are applied by renderDirtyRect.
+ *
+ * Rendering happens on the GUI thread, since tile images are pixmaps shared
+ * with the map.
+ */
 void MiniMap::renderMapToImage()
 {
+    mDirtyRect = QRect();
+
     if (!mMapDocument) {
         mMapImage = QImage();
         return;
@@ -190,7 +213,67 @@ void MiniMap::renderMapToImage()
     if (imageSize.isEmpty())
         return;
 
-    miniMapRenderer.renderToImage(mMapImage, mRenderFlags);
+    mMapImageTransform = miniMapRenderer.imageTransform(imageSize, mRenderFlags);
+    miniMapRenderer.renderToImage(mMapImage, renderFlagsFor(mMapImageTransform));
+}
+
+/**
+ * Updates only the part of the minimap image affected by recent changes to
+ * tile layers.
+ */
+void MiniMap::renderDirtyRect()
+{
+    const QRect dirtyRect = mDirtyRect;
+    mDirtyRect = QRect();
+
+    if (!mMapDocument || mMapImage.isNull())
+        return;
+
+    MiniMapRenderer miniMapRenderer(mMapDocument->map());
+
+    // When the map bounds changed the whole image needs to be updated
+    if (miniMapRenderer.imageTransform(mMapImage.size(), mRenderFlags) != mMapImageTransform) {
+        scheduleMapImageUpdate();
+        return;
+    }
+
+    miniMapRenderer.renderToImage(mMapImage, renderFlagsFor(mMapImageTransform), dirtyRect);
+}
+
+/**
+ * Returns the flags to render the map with the given \a transform. When the
+ * tiles end up smaller than two pixels, they are drawn using their average
+ * colors, which is a lot faster for large maps.
+ */
+MiniMapRenderer::RenderFlags MiniMap::renderFlagsFor(const QTransform &transform) const
+{
+    auto renderFlags = mRenderFlags;
+    const Map *map = mMapDocument->map();
+
+    if (map->tileWidth() * transform.m11() < 2 && map->tileHeight() * transform.m22() < 2)
+        renderFlags |= MiniMapRenderer::DrawTileColors;
+
+    return renderFlags;
+}
+
+void MiniMap::regionChanged(const QRegion &region, TileLayer *tileLayer)
+{
+    const MapRenderer *renderer = mMapDocument->renderer();
+    const QMargins margins = mMapDocument->map()->drawMargins();
+    const QRectF boundingRect = renderer->boundingRect(region.boundingRect()).marginsAdded(margins);
+    const QRect changedRect = boundingRect.translated(tileLayer->totalOffset()).toAlignedRect();
+
+    mDirtyRect |= changedRect;
+    update();
+}
+
+void MiniMap::undoIndexChanged()
+{
+    // Changes to tiles are already handled by regionChanged
+    if (!mRegionChangedSinceIndexChange)
+        scheduleMapImageUpdate();
+
+    mRegionChangedSinceIndexChange = false;
 }
 
 void MiniMap::centerViewOnLocalPixel(const QPointF &centerPos, int delta)
@@ -30,6 +30,7 @@
 namespace Tiled {
 
 class MapDocument;
+class TileLayer;
 
 class MiniMap : public QFrame
 {
@@ -59,21 +60,28 @@ protected:
 
 private:
     void redrawTimeout();
+    void regionChanged(const QRegion &region, TileLayer *tileLayer);
+    void undoIndexChanged();
 
     MapDocument *mMapDocument;
     QImage mMapImage;
+    QTransform mMapImageTransform;
     QRect mImageRect;
+    QRect mDirtyRect;
     QTimer mMapImageUpdateTimer;
     bool mDragging;
     QPoint mDragOffset;
     bool mMouseMoveCursorState;
     bool mRedrawMapImage;
+    bool mRegionChangedSinceIndexChange;
     MiniMapRenderer::RenderFlags mRenderFlags;
 
     QRect viewportRect() const;
     QPointF mapToScene(QPointF p) const;
     void updateImageRect();
     void renderMapToImage();
+    MiniMapRenderer::RenderFlags renderFlagsFor(const QTransform &transform) const;
+    void renderDirtyRect();
     void centerViewOnLocalPixel(const QPointF &centerPos, int delta = 0);
 };
 
@@ -20,15 +20,106 @@
 
 #include "painttilelayer.h"
 
+#include "compression.h"
 #include "map.h"
 #include "mapdocument.h"
 #include "tilelayer.h"
 #include "tilepainter.h"
 
 #include <QCoreApplication>
+#include <QDebug>
 
 using namespace Tiled;
 
+namespace {
+
+enum PackedCellFlags {
+    PackedFlippedHorizontally   = 0x01,
+    PackedFlippedVertically     = 0x02,
+    PackedFlippedAntiDiagonally = 0x04,
+    PackedRotatedHexagonal120   = 0x08,
+    PackedChecked               = 0x10,
+};
+
+CompressionMethod snapshotCompressionMethod()
+{
+    return compressionSupported(Zstandard) ? Zstandard : Zlib;
+}
+
+} // anonymous namespace
+
+/**
+ * Appends the non-empty cells of \a layer to \a words, as their position,
+ * tileset index, tile ID and flags, preceded by the number of cells.
+ */
+void Tiled::packCells(const TileLayer &layer,
+                      QVector<SharedTileset> &tilesets,
+                      QVector<qint32> &words)
+{
+    const int countIndex = words.size();
+    words.append(0);
+
+    Tileset *lastTileset = nullptr;
+    qint32 lastTilesetIndex = -1;
+
+    for (auto it = layer.begin(), it_end = layer.end(); it != it_end; ++it) {
+        const Cell &cell = it.value();
+        if (cell == Cell::empty && !cell.checked())
+            continue;
+
+        Tileset *tileset = cell.tileset();
+        if (tileset != lastTileset) {
+            lastTileset = tileset;
+            lastTilesetIndex = -1;
+
+            if (tileset) {
+                const SharedTileset sharedTileset = tileset->sharedFromThis();
+                lastTilesetIndex = tilesets.indexOf(sharedTileset);
+                if (lastTilesetIndex == -1) {
+                    lastTilesetIndex = tilesets.size();
+                    tilesets.append(sharedTileset);
+                }
+            }
+        }
+
+        const int flags = (cell.flippedHorizontally() ? PackedFlippedHorizontally : 0) |
+                (cell.flippedVertically() ? PackedFlippedVertically : 0) |
+                (cell.flippedAntiDiagonally() ? PackedFlippedAntiDiagonally : 0) |
+                (cell.rotatedHexagonal120() ? PackedRotatedHexagonal120 : 0) |
+                (cell.checked() ? PackedChecked : 0);
+
+        const QPoint pos = it.key();
+        words << pos.x() << pos.y() << lastTilesetIndex << cell.tileId() << flags;
+        ++words[countIndex];
+    }
+}
+
+/**
+ * Reads back cells written by packCells, advancing \a words past them.
+ */
+std::unique_ptr<TileLayer> Tiled::unpackCells(const qint32 *&words,
+                                              const QVector<SharedTileset> &tilesets)
+{
+    auto layer = std::make_unique<TileLayer>();
+
+    const qint32 count = *words++;
+    for (qint32 i = 0; i < count; ++i, words += 5) {
+        const int tilesetIndex = words[2];
+        const int flags = words[4];
+
+        Cell cell(tilesetIndex == -1 ? nullptr : tilesets.at(tilesetIndex).data(), words[3]);
+        cell.setFlippedHorizontally(flags & PackedFlippedHorizontally);
+        cell.setFlippedVertically(flags & PackedFlippedVertically);
+        cell.setFlippedAntiDiagonally(flags & PackedFlippedAntiDiagonally);
+        cell.setRotatedHexagonal120(flags & PackedRotatedHexagonal120);
+        cell.setChecked(flags & PackedChecked);
+
+        layer->setCell(words[0], words[1], cell);
+    }
+
+    return layer;
+}
+
 PaintTileLayer::PaintTileLayer(MapDocument *mapDocument, QUndoCommand *parent)
     : QUndoCommand(parent)
     , mMapDocument(mapDocument)
@@ -68,7 +159,9 @@ void PaintTileLayer::paint(TileLayer *target,
                            target->y(), target, paintRegion);
     data.mPaintedRegion = paintRegion;
 
+    decompress();
     mLayerData[target].mergeWith(std::move(data));
+    mMemoryUsage = -1;
 }
 
 void PaintTileLayer::erase(TileLayer *target, const QRegion &eraseRegion)
@@ -79,6 +172,17 @@ void PaintTileLayer::erase(TileLayer *target, const QRegion &eraseRegion)
 
 void PaintTileLayer::undo()
 {
+    if (mDiscarded) {
+        // The tiles are no longer restored, so the document will not be in
+        // the state it was in at any of the indexes before this command.
+        // Marking the command obsolete makes the stack remove it.
+        mMapDocument->undoStack()->resetClean();
+        setObsolete(true);
+        return;
+    }
+
+    decompress();
+
     for (const auto& [tileLayer, data] : mLayerData) {
         TilePainter painter(mMapDocument, tileLayer);
         painter.setCells(0, 0, data.mErased.get(), data.mPaintedRegion);
@@ -89,6 +193,11 @@ void PaintTileLayer::undo()
 
 void PaintTileLayer::redo()
 {
+    if (mDiscarded)
+        return;
+
+    decompress();
+
     QUndoCommand::redo(); // redo child commands
 
     for (const auto& [tileLayer, data] : mLayerData) {
@@ -117,6 +226,70 @@ void PaintTileLayer::LayerData::mergeWith(LayerData &&o)
         copy(o);
 }
 
+/**
+ * Packs the snapshots into a compressed buffer and releases them. The
+ * snapshots are kept when compression fails.
+ */
+void PaintTileLayer::LayerData::compress()
+{
+    if (!mSource)
+        return;
+
+    QVector<qint32> words;
+    QVector<SharedTileset> tilesets;
+    packCells(*mSource, tilesets, words);
+    packCells(*mErased, tilesets, words);
+
+    const QByteArray data(reinterpret_cast<const char*>(words.constData()),
+                          words.size() * int(sizeof(qint32)));
+    const QByteArray compressed = Tiled::compress(data, snapshotCompressionMethod());
+    if (compressed.isNull())
+        return;
+
+    mCompressed = compressed;
+    mUncompressedSize = data.size();
+    mTilesets = tilesets;
+    mSource.reset();
+    mErased.reset();
+}
+
+void PaintTileLayer::LayerData::decompress()
+{
+    if (mSource || mCompressed.isEmpty())
+        return;
+
+    const QByteArray data = Tiled::decompress(mCompressed, mUncompressedSize,
+                                              snapshotCompressionMethod());
+
+    if (data.size() == mUncompressedSize) {
+        const qint32 *words = reinterpret_cast<const qint32*>(data.constData());
+        mSource = unpackCells(words, mTilesets);
+        mErased = unpackCells(words, mTilesets);
+    } else {
+        qWarning() << "Failed to decompress tile layer snapshot";
+        mSource = std::make_unique<TileLayer>();
+        mErased = std::make_unique<TileLayer>();
+    }
+
+    mCompressed.clear();
+    mUncompressedSize = 0;
+    mTilesets.clear();
+}
+
+qint64 PaintTileLayer::LayerData::memoryUsage() const
+{
+    qint64 usage = qint64(mPaintedRegion.rectCount()) * qint64(sizeof(QRect));
+
+    if (mSource) {
+        const int chunkCount = mSource->chunkCount() + mErased->chunkCount();
+        usage += qint64(chunkCount) * CHUNK_SIZE * CHUNK_SIZE * qint64(sizeof(Cell));
+    } else {
+        usage += mCompressed.size();
+    }
+
+    return usage;
+}
+
 void PaintTileLayer::LayerData::copy(const LayerData &o)
 {
     // Copy the newly painted tiles as well as the newly erased tiles over
@@ -130,11 +303,67 @@ bool PaintTileLayer::mergeWith(const QUndoCommand *other)
     const PaintTileLayer *o = static_cast<const PaintTileLayer*>(other);
     if (!(mMapDocument == o->mMapDocument && o->mMergeable))
         return false;
+    if (mDiscarded || o->mDiscarded)
+        return false;
     if (!cloneChildren(other, this))
         return false;
 
+    decompress();
+
     for (const auto& [tileLayer, data] : o->mLayerData)
         mLayerData[tileLayer].mergeWith(data);
 
+    mMemoryUsage = -1;
     return true;
 }
+
+/**
+ * Returns the approximate number of bytes used by the tile layer snapshots of
+ * this command.
+ */
+qint64 PaintTileLayer::memoryUsage() const
+{
+    if (mMemoryUsage == -1) {
+        mMemoryUsage = 0;
+        for (const auto& [tileLayer, data] : mLayerData)
+            mMemoryUsage += data.memoryUsage();
+    }
+    return mMemoryUsage;
+}
+
+/**
+ * Compresses the tile layer snapshots of this command. They are decompressed
+ * again when needed.
+ */
+void PaintTileLayer::compress()
+{
+    for (auto& [tileLayer, data] : mLayerData)
+        data.compress();
+
+    mMemoryUsage = -1;
+}
+
+void PaintTileLayer::decompress()
+{
+    for (auto& [tileLayer, data] : mLayerData)
+        data.decompress();
+
+    mMemoryUsage = -1;
+}
+
+/**
+ * Releases the tile layer snapshots of this command, after which undoing it
+ * has no effect. Undoing it also removes it from the stack and resets the
+ * clean state, since the document is then modified at every index.
+ */
+void PaintTileLayer::discard()
+{
+    if (mDiscarded)
+        return;
+
+    mDiscarded = true;
+    mLayerData.clear();
+    mMemoryUsage = 0;
+
+    setText(QCoreApplication::translate("Undo Commands", "%1 (discarded)").arg(text()));
+}
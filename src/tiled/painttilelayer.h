@@ -20,10 +20,14 @@
 
 #pragma once
 
+#include "tilededitor_global.h"
+#include "tileset.h"
 #include "undocommands.h"
 
+#include <QByteArray>
 #include <QRegion>
 #include <QUndoCommand>
+#include <QVector>
 
 #include <memory>
 #include <unordered_map>
@@ -40,7 +44,7 @@ class MapDocument;
  * Can merge with additional commands, even when they paint on different
  * tile layers.
  */
-class PaintTileLayer : public QUndoCommand
+class TILED_EDITOR_EXPORT PaintTileLayer : public QUndoCommand
 {
 public:
     /**
@@ -90,23 +94,41 @@ public:
     int id() const override { return Cmd_PaintTileLayer; }
     bool mergeWith(const QUndoCommand *other) override;
 
+    qint64 memoryUsage() const;
+    void compress();
+    void discard();
+
 private:
     struct LayerData
     {
         void mergeWith(const LayerData &o);
         void mergeWith(LayerData &&o);
 
+        void compress();
+        void decompress();
+        qint64 memoryUsage() const;
+
         std::unique_ptr<TileLayer> mSource;
         std::unique_ptr<TileLayer> mErased;
         QRegion mPaintedRegion;
 
+        // The packed and compressed cells of mSource and mErased, while those
+        // are released
+        QByteArray mCompressed;
+        int mUncompressedSize = 0;
+        QVector<SharedTileset> mTilesets;
+
     private:
         void copy(const LayerData &o);
     };
 
+    void decompress();
+
     MapDocument *mMapDocument;
     std::unordered_map<TileLayer*, LayerData> mLayerData;
     bool mMergeable;
+    bool mDiscarded = false;
+    mutable qint64 mMemoryUsage = -1;
 };
 
 inline void PaintTileLayer::setMergeable(bool mergeable)
@@ -114,4 +136,11 @@ inline void PaintTileLayer::setMergeable(bool mergeable)
     mMergeable = mergeable;
 }
 
+TILED_EDITOR_EXPORT void packCells(const TileLayer &layer,
+                                   QVector<SharedTileset> &tilesets,
+                                   QVector<qint32> &words);
+
+TILED_EDITOR_EXPORT std::unique_ptr<TileLayer> unpackCells(const qint32 *&words,
+                                                           const QVector<SharedTileset> &tilesets);
+
 } // namespace Tiled
@@ -26,6 +26,8 @@
 #include "savefile.h"
 #include "session.h"
 #include "tilesetmanager.h"
+#include "tintedpixmapcache.h"
+#include "undomemorylimiter.h"
 
 #include <QApplication>
 #include <QDir>
@@ -86,6 +88,8 @@ void Preferences::initialize()
         dataDir.mkpath(QStringLiteral("."));
 
     SaveFile::setSafeSavingEnabled(safeSavingEnabled());
+    TintedPixmapCache::setMaxSize(tintCacheSize());
+    UndoMemoryLimiter::setMemoryLimit(qint64(undoMemoryLimit()) * 1024 * 1024);
 
     // Backwards compatibility check since 'FusionStyle' was removed from the
     // preferences dialog.
@@ -539,6 +543,36 @@ void Preferences::setUseOpenGL(bool useOpenGL)
     emit useOpenGLChanged(useOpenGL);
 }
 
+/**
+ * Returns the maximum size in megabytes used for caching tinted tileset
+ * images.
+ */
+int Preferences::tintCacheSize() const
+{
+    return get("Interface/TintCacheSize", 100);
+}
+
+void Preferences::setTintCacheSize(int megabytes)
+{
+    setValue(QLatin1String("Interface/TintCacheSize"), megabytes);
+    TintedPixmapCache::setMaxSize(megabytes);
+}
+
+/**
+ * Returns the maximum size in megabytes of the tile layer changes kept in the
+ * undo history of each document.
+ */
+int Preferences::undoMemoryLimit() const
+{
+    return get("Interface/UndoMemoryLimit", 1024);
+}
+
+void Preferences::setUndoMemoryLimit(int megabytes)
+{
+    setValue(QLatin1String("Interface/UndoMemoryLimit"), megabytes);
+    UndoMemoryLimiter::setMemoryLimit(qint64(megabytes) * 1024 * 1024);
+}
+
 void Preferences::setPropertyTypes(const SharedPropertyTypes &propertyTypes)
 {
     Object::setPropertyTypes(propertyTypes);
@@ -139,6 +139,12 @@ public:
     bool useOpenGL() const;
     void setUseOpenGL(bool useOpenGL);
 
+    int tintCacheSize() const;
+    void setTintCacheSize(int megabytes);
+
+    int undoMemoryLimit() const;
+    void setUndoMemoryLimit(int megabytes);
+
     void setPropertyTypes(const SharedPropertyTypes &propertyTypes);
 
     void setObjectTypesFile(const QString &filePath);
@@ -28,6 +28,7 @@
 #include "pluginlistmodel.h"
 #include "preferences.h"
 #include "scriptmanager.h"
+#include "tintedpixmapcache.h"
 #ifdef TILED_SENTRY
 #include "sentryhelper.h"
 #endif
@@ -133,6 +134,10 @@ PreferencesDialog::PreferencesDialog(QWidget *parent)
             this, [] (bool checked) { MapObjectItem::preciseTileObjectSelection = checked; });
     connect(mUi->openGL, &QCheckBox::toggled,
             preferences, &Preferences::setUseOpenGL);
+    connect(mUi->tintCacheSize, static_cast<void(QSpinBox::*)(int)>(&QSpinBox::valueChanged),
+            preferences, &Preferences::setTintCacheSize);
+    connect(mUi->undoMemoryLimit, static_cast<void(QSpinBox::*)(int)>(&QSpinBox::valueChanged),
+            preferences, &Preferences::setUndoMemoryLimit);
     connect(mUi->wheelZoomsByDefault, &QCheckBox::toggled,
             preferences, &Preferences::setWheelZoomsByDefault);
     connect(mUi->autoScrolling, &QCheckBox::toggled,
@@ -227,6 +232,15 @@ void PreferencesDialog::fromPreferences()
     mUi->preciseTileObjectSelection->setChecked(MapObjectItem::preciseTileObjectSelection);
     if (mUi->openGL->isEnabled())
         mUi->openGL->setChecked(prefs->useOpenGL());
+    mUi->tintCacheSize->setValue(prefs->tintCacheSize());
+    const auto tintCacheStatistics = TintedPixmapCache::statistics();
+    mUi->tintCacheSize->setToolTip(tr("Currently using %1 MB for %2 images, %3 MB of which are kept for visible layers (%4 hits, %5 misses)")
+                                   .arg(tintCacheStatistics.usedKilobytes / 1024)
+                                   .arg(tintCacheStatistics.pixmapCount)
+                                   .arg(tintCacheStatistics.pinnedKilobytes / 1024)
+                                   .arg(tintCacheStatistics.hits)
+                                   .arg(tintCacheStatistics.misses));
+    mUi->undoMemoryLimit->setValue(prefs->undoMemoryLimit());
     mUi->wheelZoomsByDefault->setChecked(prefs->wheelZoomsByDefault());
     mUi->autoScrolling->setChecked(MapView::ourAutoScrollingEnabled);
     mUi->smoothScrolling->setChecked(MapView::ourSmoothScrollingEnabled);
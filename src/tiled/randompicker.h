@@ -20,9 +20,12 @@
 
 #pragma once
 
-#include <QMap>
+#include <QVector>
 
+#include <algorithm>
+#include <initializer_list>
 #include <random>
+#include <vector>
 
 namespace Tiled {
 
@@ -32,9 +35,61 @@ inline std::default_random_engine &globalRandomEngine()
     return engine;
 }
 
+/**
+ * A small and fast random number generator (SplitMix64), seeded by hashing
+ * the given \a values.
+ *
+ * Useful for deriving random decisions from a seed and for example a location,
+ * which makes these decisions independent of the order in which they are
+ * made, and hence of the number of threads involved.
+ */
+class SeededRandom
+{
+public:
+    using result_type = quint64;
+
+    explicit SeededRandom(std::initializer_list<quint64> values)
+    {
+        for (const quint64 value : values)
+            mState = mix(mState ^ value);
+    }
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return ~result_type(0); }
+
+    result_type operator()()
+    {
+        mState += 0x9e3779b97f4a7c15;
+        return mix(mState);
+    }
+
+    /**
+     * Returns a random number in the range [0, 1).
+     */
+    double real()
+    {
+        return ((*this)() >> 11) * (1.0 / 9007199254740992.0);
+    }
+
+private:
+    static quint64 mix(quint64 z)
+    {
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+        return z ^ (z >> 31);
+    }
+
+    quint64 mState = 0;
+};
+
 /**
  * A class that helps pick random things that each have a probability
  * assigned.
+ *
+ * Picking uses the alias method (Vose), which takes constant time regardless
+ * of the number of values. The alias table is built on the first pick after
+ * the values have changed, so pick() should not be called concurrently on
+ * a picker that was just changed.
  */
 template<typename T, typename Real = qreal>
 class RandomPicker
@@ -48,61 +103,139 @@ public:
     {
         if (probability > 0) {
             mSum += probability;
-            mThresholds.insert(mSum, value);
+            mValues.append(value);
+            mProbabilities.push_back(probability);
+            mAliasesValid = false;
         }
     }
 
     bool isEmpty() const
     {
-        return mThresholds.isEmpty();
+        return mValues.isEmpty();
     }
 
     qsizetype size() const
     {
-        return mThresholds.size();
+        return mValues.size();
     }
 
     const T &pick() const
+    {
+        return pick(globalRandomEngine());
+    }
+
+    /**
+     * Picks a value using the given random number \a engine.
+     */
+    template<typename Engine>
+    const T &pick(Engine &engine) const
     {
         Q_ASSERT(!isEmpty());
 
-        if (mThresholds.size() == 1)
-            return mThresholds.first();
+        const qsizetype count = mValues.size();
+        if (count == 1)
+            return mValues.first();
 
-        std::uniform_real_distribution<Real> dis(0, mSum);
-        const Real random = dis(globalRandomEngine());
-        auto it = mThresholds.lowerBound(random);
-        if (it == mThresholds.end())
-            --it;
+        if (!mAliasesValid)
+            buildAliases();
+
+        // A single random number selects both the column and the side
+        std::uniform_real_distribution<Real> dis(0, count);
+        const Real random = dis(engine);
+        const qsizetype column = std::min(static_cast<qsizetype>(random), count - 1);
+        const Real fraction = random - column;
 
-        return it.value();
+        if (fraction < mAliasProbabilities[column])
+            return mValues.at(column);
+        return mValues.at(mAliases[column]);
     }
 
     //same as pick, but removes the selected element.
     T take()
+    {
+        return take(globalRandomEngine());
+    }
+
+    template<typename Engine>
+    T take(Engine &engine)
     {
         Q_ASSERT(!isEmpty());
 
+        // Since the alias table would need to be rebuilt anyway, this just
+        // walks the probabilities.
         std::uniform_real_distribution<Real> dis(0, mSum);
-        const Real random = dis(globalRandomEngine());
-        auto it = mThresholds.lowerBound(random);
-        if (it == mThresholds.end())
-            --it;
+        Real random = dis(engine);
+
+        const qsizetype last = mValues.size() - 1;
+        qsizetype index = 0;
+        while (index < last && random >= mProbabilities[index]) {
+            random -= mProbabilities[index];
+            ++index;
+        }
 
-        const T result = it.value();
-        mThresholds.erase(it);
+        const T result = mValues.at(index);
+        mSum -= mProbabilities[index];
+        mValues.remove(index);
+        mProbabilities.erase(mProbabilities.begin() + index);
+        mAliasesValid = false;
         return result;
     }
 
     void clear()
     {
         mSum = 0.0;
-        mThresholds.clear();
+        mValues.clear();
+        mProbabilities.clear();
+        mAliasesValid = false;
     }
 
 private:
+    void buildAliases() const
+    {
+        const qsizetype count = mValues.size();
+        mAliasProbabilities.resize(count);
+        mAliases.resize(count);
+
+        std::vector<qsizetype> small;
+        std::vector<qsizetype> large;
+
+        for (qsizetype i = 0; i < count; ++i) {
+            mAliasProbabilities[i] = mProbabilities[i] * count / mSum;
+            mAliases[i] = i;
+            (mAliasProbabilities[i] < 1 ? small : large).push_back(i);
+        }
+
+        // Fill up each column below 1 with part of a column above 1
+        while (!small.empty() && !large.empty()) {
+            const qsizetype s = small.back();
+            const qsizetype l = large.back();
+            small.pop_back();
+
+            mAliases[s] = l;
+            mAliasProbabilities[l] -= 1 - mAliasProbabilities[s];
+
+            if (mAliasProbabilities[l] < 1) {
+                large.pop_back();
+                small.push_back(l);
+            }
+        }
+
+        // Remaining columns are full, up to rounding errors
+        for (const qsizetype i : small)
+            mAliasProbabilities[i] = 1;
+        for (const qsizetype i : large)
+            mAliasProbabilities[i] = 1;
+
+        mAliasesValid = true;
+    }
+
     Real mSum;
-    QMap<Real, T> mThresholds;
+    QVector<T> mValues;
+    std::vector<Real> mProbabilities;
+
+    mutable std::vector<Real> mAliasProbabilities;
+    mutable std::vector<qsizetype> mAliases;
+    mutable bool mAliasesValid = false;
 };
 
 } // namespace Tiled
@@ -0,0 +1,92 @@
+/*
+ * rulesmapcache.cpp
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "rulesmapcache.h"
+
+#include "map.h"
+#include "mapformat.h"
+
+#include <QFileInfo>
+
+using namespace Tiled;
+
+RulesMapCache *RulesMapCache::mInstance;
+
+RulesMapCache *RulesMapCache::instance()
+{
+    if (!mInstance)
+        mInstance = new RulesMapCache;
+
+    return mInstance;
+}
+
+/**
+ * Deletes the cache. Needs to be called before the TilesetManager is
+ * deleted.
+ */
+void RulesMapCache::deleteInstance()
+{
+    delete mInstance;
+    mInstance = nullptr;
+}
+
+/**
+ * Returns the rule map stored at \a filePath, which is loaded unless it is
+ * still in use and hasn't changed since it was loaded.
+ *
+ * Returns null and sets \a errorString when the map could not be loaded.
+ */
+std::shared_ptr<const Map> RulesMapCache::load(const QString &filePath,
+                                               QString *errorString)
+{
+    const QString absolutePath = QFileInfo(filePath).absoluteFilePath();
+    const QDateTime lastModified = QFileInfo(absolutePath).lastModified();
+
+    // Drop the entries that are no longer in use
+    for (auto it = mEntries.begin(); it != mEntries.end();) {
+        if (it->rulesMap.expired())
+            it = mEntries.erase(it);
+        else
+            ++it;
+    }
+
+    auto it = mEntries.constFind(absolutePath);
+    if (it != mEntries.constEnd() && it->lastModified == lastModified) {
+        if (auto rulesMap = it->rulesMap.lock())
+            return rulesMap;
+    }
+
+    std::shared_ptr<const Map> rulesMap { readMap(filePath, errorString) };
+    if (rulesMap)
+        mEntries.insert(absolutePath, Entry { lastModified, rulesMap });
+    else
+        mEntries.remove(absolutePath);
+
+    return rulesMap;
+}
+
+/**
+ * Makes sure the rule map stored at \a filePath is loaded again the next
+ * time it is needed.
+ */
+void RulesMapCache::remove(const QString &filePath)
+{
+    mEntries.remove(QFileInfo(filePath).absoluteFilePath());
+}
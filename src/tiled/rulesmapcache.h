@@ -0,0 +1,71 @@
+/*
+ * rulesmapcache.h
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <QDateTime>
+#include <QHash>
+#include <QString>
+
+#include <memory>
+
+namespace Tiled {
+
+class Map;
+
+/**
+ * Shares the loaded rule maps between all AutomappingManager instances, so
+ * that they don't need to be loaded again when switching between maps using
+ * the same rules, and aren't kept in memory more than once.
+ *
+ * The cache does not keep the rule maps alive by itself. An entry is only
+ * available while it is referenced by an AutomappingManager and the file has
+ * not been modified since it was loaded.
+ *
+ * The rule maps are shared read-only. Each AutoMapper works on its own copy,
+ * since preparing it for a map changes the tilesets used by its rule map.
+ */
+class RulesMapCache
+{
+public:
+    static RulesMapCache *instance();
+    static void deleteInstance();
+
+    std::shared_ptr<const Map> load(const QString &filePath,
+                                    QString *errorString);
+    void remove(const QString &filePath);
+
+private:
+    Q_DISABLE_COPY(RulesMapCache)
+
+    RulesMapCache() = default;
+
+    struct Entry
+    {
+        QDateTime lastModified;
+        std::weak_ptr<const Map> rulesMap;
+    };
+
+    QHash<QString, Entry> mEntries;
+
+    static RulesMapCache *mInstance;
+};
+
+} // namespace Tiled
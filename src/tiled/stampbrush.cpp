@@ -93,7 +93,8 @@ void StampBrush::tilePositionChanged(QPoint pos)
         QHash<TileLayer*, QRegion> paintedRegions;
 
         for (int i = 1; i < points.size(); ++i) {
-            drawPreviewLayer(QVector<QPoint>() << points.at(i));
+            if (!movePreviewLayer(points.at(i)))
+                drawPreviewLayer(QVector<QPoint>() << points.at(i));
 
             // Only update the brush item for the last drawn piece
             if (i == points.size() - 1)
@@ -400,6 +401,7 @@ static void shiftColumns(TileLayer *tileLayer, Map::StaggerIndex staggerIndex)
 void StampBrush::drawPreviewLayer(const QVector<QPoint> &points)
 {
     mPreviewMap.clear();
+    mPreviewMovable = false;
 
     if (mStamp.isEmpty() && !mIsWangFill)
         return;
@@ -427,8 +429,10 @@ void StampBrush::drawPreviewLayer(const QVector<QPoint> &points)
             new TileLayer(QString(), bounds.topLeft(), bounds.size())
         };
 
+        SeededRandom random({ globalRandomEngine()() });
+
         for (const QPoint &p : points) {
-            const Cell &cell = mRandomCellPicker.pick();
+            const Cell &cell = mRandomCellPicker.pick(random);
             previewLayer->setCell(p.x() - bounds.left(),
                                   p.y() - bounds.top(),
                                   cell);
@@ -591,9 +595,52 @@ void StampBrush::drawPreviewLayer(const QVector<QPoint> &points)
 
         preview->addTilesets(preview->usedTilesets());
         mPreviewMap = preview;
+
+        // A single stamp without variations looks the same everywhere on
+        // non-staggered maps, so it can be moved along with the mouse.
+        if (points.size() == 1 && operations.size() == 1 && shiftedCopies.isEmpty() &&
+                mStamp.variations().size() == 1) {
+            mPreviewMovable = true;
+            mPreviewPosition = points.first();
+            mPreviewRegion = paintedRegion;
+            mPreviewStamp = mStamp;
+            mPreviewDocument = mapDocument();
+            mPreviewTilesets = mapDocument()->map()->tilesets();
+            mPreviewMissingTilesets = mMissingTilesets;
+        }
     }
 }
 
+/**
+ * Moves the current preview to be centered on \a pos, when it was drawn for a
+ * single position and is still valid. Returns whether the preview was moved.
+ */
+bool StampBrush::movePreviewLayer(QPoint pos)
+{
+    if (!mPreviewMovable || !mPreviewMap || mIsRandom || mIsWangFill)
+        return false;
+
+    const Map *map = mapDocument()->map();
+    if (mPreviewDocument != mapDocument() ||
+            !(mPreviewStamp == mStamp) ||
+            mPreviewMap->orientation() != map->orientation() ||
+            map->isStaggered() ||
+            mPreviewTilesets != map->tilesets())
+        return false;
+
+    const QPoint offset = pos - mPreviewPosition;
+    for (Layer *layer : mPreviewMap->tileLayers())
+        layer->setPosition(layer->position() + offset);
+
+    mPreviewPosition = pos;
+    mPreviewRegion.translate(offset);
+
+    // Painting clears the missing tilesets, but when the tilesets are back to
+    // the state of the preview they are missing again.
+    mMissingTilesets = mPreviewMissingTilesets;
+    return true;
+}
+
 /**
  * Updates the position of the brush item based on the mouse position.
  */
@@ -633,11 +680,14 @@ void StampBrush::updatePreview(QPoint tilePos)
         case Line:
         case Free:
         case Paint:
-            drawPreviewLayer(QVector<QPoint>() << tilePos);
+            if (movePreviewLayer(tilePos))
+                tileRegion = mPreviewRegion;
+            else
+                drawPreviewLayer(QVector<QPoint>() << tilePos);
             break;
         }
 
-        if (mPreviewMap)
+        if (mPreviewMap && tileRegion.isEmpty())
             tileRegion = mPreviewMap->modifiedTileRegion();
 
         if (tileRegion.isEmpty())
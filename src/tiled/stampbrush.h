@@ -119,6 +119,16 @@ private:
     QPoint mPrevTilePosition;
 
     void drawPreviewLayer(const QVector<QPoint> &points);
+    bool movePreviewLayer(QPoint pos);
+
+    // The state for which the preview can be moved rather than redrawn
+    bool mPreviewMovable = false;
+    QPoint mPreviewPosition;
+    QRegion mPreviewRegion;
+    TileStamp mPreviewStamp;
+    const MapDocument *mPreviewDocument = nullptr;
+    QVector<SharedTileset> mPreviewTilesets;
+    QVector<SharedTileset> mPreviewMissingTilesets;
 
     /**
      * There are several options how the stamp utility can be used.
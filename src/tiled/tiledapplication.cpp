@@ -25,6 +25,7 @@
 #include "newversionchecker.h"
 #include "pluginmanager.h"
 #include "preferences.h"
+#include "rulesmapcache.h"
 #include "scriptmanager.h"
 #include "session.h"
 #include "templatemanager.h"
@@ -61,6 +62,7 @@ TiledApplication::~TiledApplication()
 {
     TemplateManager::deleteInstance();
     ScriptManager::deleteInstance();
+    RulesMapCache::deleteInstance();
     TilesetManager::deleteInstance();
     Preferences::deleteInstance();
     PluginManager::deleteInstance();
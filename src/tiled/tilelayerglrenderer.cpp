@@ -0,0 +1,612 @@
+/*
+ * tilelayerglrenderer.cpp
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "tilelayerglrenderer.h"
+
+#ifndef QT_NO_OPENGL
+
+#include "map.h"
+#include "maprenderer.h"
+#include "orthogonalrenderer.h"
+#include "tile.h"
+#include "tileset.h"
+
+#include <QMatrix4x4>
+#include <QOpenGLContext>
+#include <QOpenGLFunctions>
+#include <QOpenGLShaderProgram>
+#include <QPaintEngine>
+#include <QPainter>
+#include <QRegion>
+#include <QVector4D>
+#include <QtMath>
+
+#include <cstddef>
+
+namespace Tiled {
+
+namespace {
+
+struct Vertex
+{
+    float x;
+    float y;
+    float u;    // in pixels
+    float v;    // in pixels
+};
+
+const char *vertexShaderSource =
+        "attribute highp vec2 vertexCoord;\n"
+        "attribute highp vec2 textureCoord;\n"
+        "uniform highp mat4 matrix;\n"
+        "uniform highp vec2 textureSize;\n"
+        "varying highp vec2 texCoord;\n"
+        "void main() {\n"
+        "    texCoord = textureCoord / textureSize;\n"
+        "    gl_Position = matrix * vec4(vertexCoord, 0.0, 1.0);\n"
+        "}\n";
+
+const char *fragmentShaderSource =
+        "uniform sampler2D atlas;\n"
+        "uniform lowp vec4 color;\n"
+        "varying highp vec2 texCoord;\n"
+        "void main() {\n"
+        "    lowp vec4 texel = texture2D(atlas, texCoord);\n"
+        "    gl_FragColor = vec4(texel.rgb * texel.a, texel.a) * color;\n"
+        "}\n";
+
+enum {
+    VertexCoordLocation = 0,
+    TextureCoordLocation = 1
+};
+
+} // anonymous namespace
+
+/**
+ * The OpenGL resources shared by all tile layers that are rendered using a
+ * certain context. It is owned by that context.
+ */
+class TileLayerGLResources : public QObject
+{
+public:
+    static TileLayerGLResources *forContext(QOpenGLContext *context);
+
+    ~TileLayerGLResources() override;
+
+    bool isValid() const { return mProgram.isLinked(); }
+
+    QOpenGLShaderProgram &program() { return mProgram; }
+
+    GLuint texture(const QPixmap &image);
+    void releaseUnusedTextures();
+
+private:
+    explicit TileLayerGLResources(QOpenGLContext *context);
+
+    void deleteTextures();
+
+    struct Texture
+    {
+        QPixmap image;
+        GLuint id;
+    };
+
+    QOpenGLContext *mContext;
+    QOpenGLShaderProgram mProgram;
+    QHash<qint64, Texture> mTextures;
+
+    static QHash<QOpenGLContext*, TileLayerGLResources*> sInstances;
+};
+
+QHash<QOpenGLContext*, TileLayerGLResources*> TileLayerGLResources::sInstances;
+
+TileLayerGLResources *TileLayerGLResources::forContext(QOpenGLContext *context)
+{
+    auto &resources = sInstances[context];
+    if (!resources)
+        resources = new TileLayerGLResources(context);
+    return resources;
+}
+
+TileLayerGLResources::TileLayerGLResources(QOpenGLContext *context)
+    : QObject(context)
+    , mContext(context)
+{
+    mProgram.addShaderFromSourceCode(QOpenGLShader::Vertex, vertexShaderSource);
+    mProgram.addShaderFromSourceCode(QOpenGLShader::Fragment, fragmentShaderSource);
+    mProgram.bindAttributeLocation("vertexCoord", VertexCoordLocation);
+    mProgram.bindAttributeLocation("textureCoord", TextureCoordLocation);
+    mProgram.link();
+
+    // Textures can only be deleted while the context is current, which is
+    // the case when the context is about to be destroyed by the viewport.
+    connect(context, &QOpenGLContext::aboutToBeDestroyed,
+            this, &TileLayerGLResources::deleteTextures, Qt::DirectConnection);
+}
+
+TileLayerGLResources::~TileLayerGLResources()
+{
+    deleteTextures();
+    sInstances.remove(mContext);
+}
+
+/**
+ * Returns the texture for the given \a image, uploading it when necessary.
+ */
+GLuint TileLayerGLResources::texture(const QPixmap &image)
+{
+    auto it = mTextures.find(image.cacheKey());
+    if (it != mTextures.end())
+        return it->id;
+
+    const QImage rgba = image.toImage().convertToFormat(QImage::Format_RGBA8888);
+
+    QOpenGLFunctions *f = mContext->functions();
+    GLuint id = 0;
+    f->glGenTextures(1, &id);
+    f->glBindTexture(GL_TEXTURE_2D, id);
+    f->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    f->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    f->glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, rgba.width(), rgba.height(), 0,
+                    GL_RGBA, GL_UNSIGNED_BYTE, rgba.constBits());
+
+    mTextures.insert(image.cacheKey(), Texture { image, id });
+    return id;
+}
+
+/**
+ * Deletes the textures of images no longer referenced outside of this class.
+ */
+void TileLayerGLResources::releaseUnusedTextures()
+{
+    QOpenGLFunctions *f = mContext->functions();
+
+    for (auto it = mTextures.begin(); it != mTextures.end(); ) {
+        if (it->image.isDetached()) {
+            f->glDeleteTextures(1, &it->id);
+            it = mTextures.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void TileLayerGLResources::deleteTextures()
+{
+    if (QOpenGLContext::currentContext() == mContext) {
+        QOpenGLFunctions *f = mContext->functions();
+        for (const Texture &texture : std::as_const(mTextures))
+            f->glDeleteTextures(1, &texture.id);
+    }
+
+    // Otherwise the textures are freed along with the context
+    mTextures.clear();
+}
+
+
+TileLayerGLRenderer::TileLayerGLRenderer(const TileLayer *tileLayer)
+    : mTileLayer(tileLayer)
+{
+}
+
+TileLayerGLRenderer::~TileLayerGLRenderer()
+{
+}
+
+static bool hasOpenGLEngine(const QPainter *painter)
+{
+    if (auto paintEngine = painter->paintEngine())
+        return paintEngine->type() == QPaintEngine::OpenGL2;
+    return false;
+}
+
+/**
+ * Returns whether the tile layer can be rendered using the given painter and
+ * renderer.
+ *
+ * Only orthogonal maps are supported, since this allows drawing the chunks
+ * in any order as long as no tiles extend beyond their cell. Drawing
+ * collision shapes is left to the MapRenderer as well.
+ */
+bool TileLayerGLRenderer::canRender(const QPainter *painter, const MapRenderer *renderer) const
+{
+    if (!hasOpenGLEngine(painter))
+        return false;
+
+    const QOpenGLContext *context = QOpenGLContext::currentContext();
+    if (!context || context->format().profile() == QSurfaceFormat::CoreProfile)
+        return false;
+
+    if (!dynamic_cast<const OrthogonalRenderer*>(renderer))
+        return false;
+
+    if (renderer->testFlag(ShowTileCollisionShapes))
+        return false;
+
+    // Make sure no tiles extend beyond their cell (see TileLayerItem)
+    const QSize tileSize = renderer->map()->tileSize();
+    const QMargins margins = mTileLayer->drawMargins();
+    return margins.left() <= 0 && margins.bottom() <= 0 &&
+            margins.top() <= tileSize.height() &&
+            margins.right() <= tileSize.width();
+}
+
+/**
+ * Renders the part of the tile layer within \a exposed (in pixels).
+ *
+ * Should only be called when canRender returned true.
+ */
+void TileLayerGLRenderer::render(QPainter *painter, const MapRenderer *renderer, const QRectF &exposed)
+{
+    QOpenGLContext *context = QOpenGLContext::currentContext();
+    TileLayerGLResources *resources = TileLayerGLResources::forContext(context);
+    if (!resources->isValid())
+        return;
+
+    if (mResources != resources) {
+        mResources = resources;
+        mChunks.clear();
+    }
+
+    const qint64 imagesKey = tilesetImagesKey();
+    const bool showTileAnimations = renderer->testFlag(ShowTileAnimations);
+    if (mTilesetImagesKey != imagesKey || mShowTileAnimations != showTileAnimations) {
+        mTilesetImagesKey = imagesKey;
+        mShowTileAnimations = showTileAnimations;
+        invalidate();
+    }
+
+    const int tileWidth = renderer->map()->tileWidth();
+    const int tileHeight = renderer->map()->tileHeight();
+    const QPoint layerPos = mTileLayer->position();
+
+    QRect tileRect = mTileLayer->localBounds();
+    if (!exposed.isNull()) {
+        const QRect exposedTiles(QPoint(qFloor(exposed.left() / tileWidth),
+                                        qFloor(exposed.top() / tileHeight)),
+                                 QPoint(qCeil(exposed.right() / tileWidth) - 1,
+                                        qCeil(exposed.bottom() / tileHeight) - 1));
+        tileRect &= exposedTiles.translated(-layerPos);
+    }
+    if (tileRect.isEmpty())
+        return;
+
+    QVector<QPoint> chunkPositions;
+    QVector<QPoint> fallbackChunks;
+
+    for (int chunkY = tileRect.top() >> CHUNK_BITS; chunkY <= tileRect.bottom() >> CHUNK_BITS; ++chunkY) {
+        for (int chunkX = tileRect.left() >> CHUNK_BITS; chunkX <= tileRect.right() >> CHUNK_BITS; ++chunkX) {
+            const QPoint chunkPos(chunkX, chunkY);
+
+            if (!mTileLayer->findChunk(chunkX << CHUNK_BITS, chunkY << CHUNK_BITS)) {
+                mChunks.remove(chunkPos);
+                continue;
+            }
+
+            ChunkBuffer &chunkBuffer = mChunks[chunkPos];
+            if (chunkBuffer.dirty || chunkBuffer.animated)
+                updateChunk(chunkBuffer, chunkPos, renderer);
+
+            if (chunkBuffer.fallback)
+                fallbackChunks.append(chunkPos);
+            else if (!chunkBuffer.batches.isEmpty())
+                chunkPositions.append(chunkPos);
+        }
+    }
+
+    // Taking pointers only after all chunks were inserted into the hash
+    QVector<ChunkBuffer*> visibleChunks;
+    visibleChunks.reserve(chunkPositions.size());
+    for (const QPoint &chunkPos : std::as_const(chunkPositions))
+        visibleChunks.append(&mChunks[chunkPos]);
+
+    resources->releaseUnusedTextures();
+
+    if (!visibleChunks.isEmpty()) {
+        const QPaintDevice *device = painter->device();
+        const qreal devicePixelRatio = device->devicePixelRatioF();
+
+        QMatrix4x4 matrix;
+        matrix.ortho(0, device->width(), device->height(), 0, -1, 1);
+        matrix *= QMatrix4x4(painter->combinedTransform());
+
+        // Premultiplied tint color, as applied by TintedPixmapCache
+        QColor tintColor = mTileLayer->effectiveTintColor();
+        if (!tintColor.isValid())
+            tintColor = Qt::white;
+        const qreal alpha = tintColor.alphaF() * painter->opacity();
+        const QVector4D color(tintColor.redF() * alpha,
+                              tintColor.greenF() * alpha,
+                              tintColor.blueF() * alpha,
+                              alpha);
+
+        const GLint filter = painter->testRenderHint(QPainter::SmoothPixmapTransform) ? GL_LINEAR
+                                                                                      : GL_NEAREST;
+
+        // Native painting ignores the clip of the painter
+        QRectF clipRect = exposed.isNull() ? QRectF(0, 0, device->width(), device->height())
+                                           : painter->combinedTransform().mapRect(exposed);
+        if (painter->hasClipping())
+            clipRect &= painter->combinedTransform().mapRect(painter->clipBoundingRect());
+        const QRect scissorRect = QRectF(clipRect.topLeft() * devicePixelRatio,
+                                         clipRect.size() * devicePixelRatio).toAlignedRect();
+        const int deviceHeight = qRound(device->height() * devicePixelRatio);
+
+        painter->beginNativePainting();
+
+        QOpenGLFunctions *f = context->functions();
+        f->glEnable(GL_BLEND);
+        f->glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+        f->glEnable(GL_SCISSOR_TEST);
+        f->glScissor(scissorRect.x(), deviceHeight - scissorRect.bottom() - 1,
+                     scissorRect.width(), scissorRect.height());
+        f->glActiveTexture(GL_TEXTURE0);
+
+        QOpenGLShaderProgram &program = resources->program();
+        program.bind();
+        program.setUniformValue("matrix", matrix);
+        program.setUniformValue("color", color);
+        program.setUniformValue("atlas", 0);
+        program.enableAttributeArray(VertexCoordLocation);
+        program.enableAttributeArray(TextureCoordLocation);
+
+        for (ChunkBuffer *chunkBuffer : std::as_const(visibleChunks)) {
+            chunkBuffer->buffer.bind();
+            program.setAttributeBuffer(VertexCoordLocation, GL_FLOAT,
+                                       offsetof(Vertex, x), 2, sizeof(Vertex));
+            program.setAttributeBuffer(TextureCoordLocation, GL_FLOAT,
+                                       offsetof(Vertex, u), 2, sizeof(Vertex));
+
+            for (const Batch &batch : chunkBuffer->batches) {
+                f->glBindTexture(GL_TEXTURE_2D, resources->texture(batch.image));
+                f->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filter);
+                f->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter);
+                program.setUniformValue("textureSize", QSizeF(batch.image.size()));
+                f->glDrawArrays(GL_TRIANGLES, batch.first, batch.count);
+            }
+
+            chunkBuffer->buffer.release();
+        }
+
+        program.disableAttributeArray(VertexCoordLocation);
+        program.disableAttributeArray(TextureCoordLocation);
+        program.release();
+        f->glBindTexture(GL_TEXTURE_2D, 0);
+        f->glDisable(GL_SCISSOR_TEST);
+
+        painter->endNativePainting();
+    }
+
+    // Chunks with tiles that can't be rendered by the above are painted
+    // using the regular cell renderer
+    if (!fallbackChunks.isEmpty()) {
+        CellRenderer cellRenderer(painter, renderer, mTileLayer->effectiveTintColor());
+        const QSize gridSize = renderer->map()->tileSize();
+
+        for (const QPoint &chunkPos : std::as_const(fallbackChunks)) {
+            const QRect chunkRect = QRect(chunkPos.x() << CHUNK_BITS, chunkPos.y() << CHUNK_BITS,
+                                          CHUNK_SIZE, CHUNK_SIZE) & tileRect;
+
+            for (int y = chunkRect.top(); y <= chunkRect.bottom(); ++y) {
+                for (int x = chunkRect.left(); x <= chunkRect.right(); ++x) {
+                    const Cell &cell = mTileLayer->cellAt(x, y);
+                    if (cell.isEmpty())
+                        continue;
+
+                    QSize size = gridSize;
+                    if (cell.tileset()->tileRenderSize() == Tileset::TileSize) {
+                        if (const Tile *tile = cell.tile())
+                            size = tile->size();
+                    }
+
+                    const QPointF screenPos((x + layerPos.x()) * tileWidth,
+                                            (y + layerPos.y() + 1) * tileHeight);
+                    cellRenderer.render(cell, screenPos, size, CellRenderer::BottomLeft);
+                }
+            }
+        }
+    }
+}
+
+/**
+ * Marks the chunks touching the given \a region (in local tile coordinates)
+ * as needing an update.
+ */
+void TileLayerGLRenderer::invalidate(const QRegion &region)
+{
+    for (const QRect &rect : region) {
+        for (int chunkY = rect.top() >> CHUNK_BITS; chunkY <= rect.bottom() >> CHUNK_BITS; ++chunkY) {
+            for (int chunkX = rect.left() >> CHUNK_BITS; chunkX <= rect.right() >> CHUNK_BITS; ++chunkX) {
+                auto it = mChunks.find(QPoint(chunkX, chunkY));
+                if (it != mChunks.end())
+                    it->dirty = true;
+            }
+        }
+    }
+}
+
+/**
+ * Marks all chunks as needing an update.
+ */
+void TileLayerGLRenderer::invalidate()
+{
+    for (ChunkBuffer &chunkBuffer : mChunks)
+        chunkBuffer.dirty = true;
+}
+
+/**
+ * Fills the vertex buffer of the chunk at \a chunkPos (in chunk coordinates).
+ *
+ * The geometry matches the one used by CellRenderer. The vertices are
+ * grouped by image, so that each image is drawn with a single draw call.
+ */
+void TileLayerGLRenderer::updateChunk(ChunkBuffer &chunkBuffer, QPoint chunkPos,
+                                      const MapRenderer *renderer)
+{
+    chunkBuffer.dirty = false;
+    chunkBuffer.animated = false;
+    chunkBuffer.fallback = false;
+    chunkBuffer.batches.clear();
+
+    const Chunk *chunk = mTileLayer->findChunk(chunkPos.x() << CHUNK_BITS,
+                                               chunkPos.y() << CHUNK_BITS);
+    if (!chunk)
+        return;
+
+    const QSize gridSize = renderer->map()->tileSize();
+    const QPoint origin = mTileLayer->position() + chunkPos * CHUNK_SIZE;
+    QVector<qint64> imageKeys;
+    QHash<qint64, QPixmap> images;
+    QHash<qint64, QVector<Vertex>> verticesByImage;
+
+    for (int y = 0; y < CHUNK_SIZE; ++y) {
+        for (int x = 0; x < CHUNK_SIZE; ++x) {
+            const Cell &cell = chunk->cellAt(x, y);
+            if (cell.isEmpty())
+                continue;
+
+            const Tile *cellTile = cell.tile();
+            const Tile *tile = cellTile;
+
+            if (tile && tile->isAnimated() && mShowTileAnimations) {
+                chunkBuffer.animated = true;
+                tile = tile->currentFrameTile();
+            }
+
+            if (!tile || tile->image().isNull()) {
+                chunkBuffer.fallback = true;
+                chunkBuffer.batches.clear();
+                return;
+            }
+
+            const QRect imageRect = tile->imageRect();
+            if (imageRect.isEmpty())
+                continue;
+
+            QSizeF size = gridSize;
+            if (cell.tileset()->tileRenderSize() == Tileset::TileSize)
+                size = cellTile->size();
+
+            const QPointF sizeHalf { size.width() / 2, size.height() / 2 };
+            const QPoint offset = tile->offset();
+
+            // Position of the center, with the tile aligned to the bottom-left
+            qreal centerX = (origin.x() + x) * gridSize.width() + sizeHalf.x();
+            qreal centerY = (origin.y() + y + 1) * gridSize.height() - sizeHalf.y();
+            qreal scaleX = size.width() / imageRect.width();
+            qreal scaleY = size.height() / imageRect.height();
+            qreal rotation = 0;
+
+            if (tile->tileset()->fillMode() == Tileset::PreserveAspectFit)
+                scaleX = scaleY = std::min(scaleX, scaleY);
+
+            centerX += offset.x() * scaleX;
+            centerY += offset.y() * scaleY;
+
+            bool flippedHorizontally = cell.flippedHorizontally();
+            bool flippedVertically = cell.flippedVertically();
+
+            if (cell.flippedAntiDiagonally()) {
+                rotation = 90;
+
+                flippedHorizontally = flippedVertically;
+                flippedVertically = !cell.flippedHorizontally();
+
+                // Compensate for the swap of image dimensions
+                const qreal halfDiff = sizeHalf.y() - sizeHalf.x();
+                centerX += halfDiff;
+                centerY += halfDiff;
+            }
+
+            QTransform transform;
+            transform.translate(centerX, centerY);
+            transform.rotate(rotation);
+            transform.scale(flippedHorizontally ? -scaleX : scaleX,
+                            flippedVertically ? -scaleY : scaleY);
+
+            const qreal halfWidth = imageRect.width() / 2.0;
+            const qreal halfHeight = imageRect.height() / 2.0;
+            const QPointF topLeft = transform.map(QPointF(-halfWidth, -halfHeight));
+            const QPointF topRight = transform.map(QPointF(halfWidth, -halfHeight));
+            const QPointF bottomLeft = transform.map(QPointF(-halfWidth, halfHeight));
+            const QPointF bottomRight = transform.map(QPointF(halfWidth, halfHeight));
+
+            const float left = imageRect.left();
+            const float top = imageRect.top();
+            const float right = left + imageRect.width();
+            const float bottom = top + imageRect.height();
+
+            const QPixmap &image = tile->image();
+            const qint64 imageKey = image.cacheKey();
+
+            auto &vertices = verticesByImage[imageKey];
+            if (vertices.isEmpty()) {
+                imageKeys.append(imageKey);
+                images.insert(imageKey, image);
+            }
+
+            // Two triangles to draw each tile
+            vertices.append({ float(topLeft.x()), float(topLeft.y()), left, top });
+            vertices.append({ float(topRight.x()), float(topRight.y()), right, top });
+            vertices.append({ float(bottomLeft.x()), float(bottomLeft.y()), left, bottom });
+            vertices.append({ float(bottomLeft.x()), float(bottomLeft.y()), left, bottom });
+            vertices.append({ float(topRight.x()), float(topRight.y()), right, top });
+            vertices.append({ float(bottomRight.x()), float(bottomRight.y()), right, bottom });
+        }
+    }
+
+    QVector<Vertex> data;
+    for (qint64 imageKey : std::as_const(imageKeys)) {
+        const QVector<Vertex> &vertices = verticesByImage[imageKey];
+        chunkBuffer.batches.append(Batch { images.value(imageKey),
+                                           static_cast<int>(data.size()),
+                                           static_cast<int>(vertices.size()) });
+        data.append(vertices);
+    }
+
+    if (data.isEmpty())
+        return;
+
+    if (!chunkBuffer.buffer.isCreated()) {
+        chunkBuffer.buffer.create();
+        chunkBuffer.buffer.setUsagePattern(chunkBuffer.animated ? QOpenGLBuffer::DynamicDraw
+                                                                : QOpenGLBuffer::StaticDraw);
+    }
+
+    chunkBuffer.buffer.bind();
+    chunkBuffer.buffer.allocate(data.constData(), static_cast<int>(data.size() * sizeof(Vertex)));
+    chunkBuffer.buffer.release();
+}
+
+/**
+ * Returns a key that changes when the image of any tileset used by the layer
+ * changes, since the vertices refer to the tileset images.
+ */
+qint64 TileLayerGLRenderer::tilesetImagesKey() const
+{
+    qint64 key = 0;
+    for (const SharedTileset &tileset : mTileLayer->usedTilesets())
+        key += tileset->image().cacheKey();
+    return key;
+}
+
+} // namespace Tiled
+
+#endif // QT_NO_OPENGL
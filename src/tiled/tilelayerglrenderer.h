@@ -0,0 +1,95 @@
+/*
+ * tilelayerglrenderer.h
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "tilededitor_global.h"
+#include "tilelayer.h"
+
+#include <QHash>
+#include <QPixmap>
+#include <QPointer>
+
+#ifndef QT_NO_OPENGL
+
+#include <QOpenGLBuffer>
+
+class QPainter;
+class QRegion;
+
+namespace Tiled {
+
+class MapRenderer;
+class TileLayerGLResources;
+
+/**
+ * Renders a tile layer using OpenGL vertex buffers, for use when painting on
+ * an OpenGL viewport.
+ *
+ * The vertices of each chunk of the layer are uploaded once and drawn using
+ * a single draw call per tileset image. Chunks are only updated when they
+ * have been invalidated, which should be done whenever their cells change.
+ *
+ * When the layer or painter can't be rendered this way, canRender returns
+ * false and the layer should be drawn using the MapRenderer instead.
+ */
+class TILED_EDITOR_EXPORT TileLayerGLRenderer
+{
+public:
+    explicit TileLayerGLRenderer(const TileLayer *tileLayer);
+    ~TileLayerGLRenderer();
+
+    bool canRender(const QPainter *painter, const MapRenderer *renderer) const;
+    void render(QPainter *painter, const MapRenderer *renderer, const QRectF &exposed);
+
+    void invalidate(const QRegion &region);
+    void invalidate();
+
+private:
+    struct Batch
+    {
+        QPixmap image;
+        int first;
+        int count;
+    };
+
+    struct ChunkBuffer
+    {
+        QOpenGLBuffer buffer;
+        QVector<Batch> batches;
+        bool dirty = true;
+        bool animated = false;
+        bool fallback = false;
+    };
+
+    void updateChunk(ChunkBuffer &chunkBuffer, QPoint chunkPos,
+                     const MapRenderer *renderer);
+    qint64 tilesetImagesKey() const;
+
+    const TileLayer *mTileLayer;
+    QHash<QPoint, ChunkBuffer> mChunks;
+    QPointer<TileLayerGLResources> mResources;
+    qint64 mTilesetImagesKey = 0;
+    bool mShowTileAnimations = true;
+};
+
+} // namespace Tiled
+
+#endif // QT_NO_OPENGL
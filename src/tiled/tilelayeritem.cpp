@@ -31,6 +31,9 @@ using namespace Tiled;
 TileLayerItem::TileLayerItem(TileLayer *layer, MapDocument *mapDocument, QGraphicsItem *parent)
     : LayerItem(layer, parent)
     , mMapDocument(mapDocument)
+#ifndef QT_NO_OPENGL
+    , mGLRenderer(layer)
+#endif
 {
     setFlag(QGraphicsItem::ItemUsesExtendedStyleOption);
 
@@ -55,6 +58,23 @@ void TileLayerItem::syncWithTileLayer()
     }
 
     mBoundingRect = boundingRect.marginsAdded(margins);
+
+#ifndef QT_NO_OPENGL
+    mGLRenderer.invalidate();
+#endif
+}
+
+/**
+ * Should be called when the cells in the given \a region (in map tile
+ * coordinates) have changed.
+ */
+void TileLayerItem::invalidateRegion(const QRegion &region)
+{
+#ifndef QT_NO_OPENGL
+    mGLRenderer.invalidate(region.translated(-tileLayer()->position()));
+#else
+    Q_UNUSED(region)
+#endif
 }
 
 QRectF TileLayerItem::boundingRect() const
@@ -67,6 +87,14 @@ void TileLayerItem::paint(QPainter *painter,
                           QWidget *)
 {
     MapRenderer *renderer = mMapDocument->renderer();
+
+#ifndef QT_NO_OPENGL
+    if (mGLRenderer.canRender(painter, renderer)) {
+        mGLRenderer.render(painter, renderer, option->exposedRect);
+        return;
+    }
+#endif
+
     // TODO: Display a border around the layer when selected
     renderer->drawTileLayer(painter, tileLayer(), option->exposedRect);
 }
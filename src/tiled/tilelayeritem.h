@@ -23,6 +23,7 @@
 #include "layeritem.h"
 
 #include "tilelayer.h"
+#include "tilelayerglrenderer.h"
 
 namespace Tiled {
 
@@ -54,6 +55,8 @@ public:
      */
     void syncWithTileLayer();
 
+    void invalidateRegion(const QRegion &region);
+
     // QGraphicsItem
     QRectF boundingRect() const override;
     void paint(QPainter *painter,
@@ -63,6 +66,9 @@ public:
 private:
     MapDocument *mMapDocument;
     QRectF mBoundingRect;
+#ifndef QT_NO_OPENGL
+    TileLayerGLRenderer mGLRenderer;
+#endif
 };
 
 inline TileLayer *TileLayerItem::tileLayer() const
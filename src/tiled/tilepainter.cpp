@@ -23,8 +23,14 @@
 
 #include "mapdocument.h"
 #include "map.h"
+#include "spans.h"
 
-#include <QQueue>
+#include <QVector>
+
+#include <algorithm>
+#include <bitset>
+#include <unordered_map>
+#include <vector>
 
 using namespace Tiled;
 
@@ -186,6 +192,71 @@ void TilePainter::erase(const QRegion &region)
     emit mMapDocument->regionChanged(paintable, mTileLayer);
 }
 
+namespace {
+
+/**
+ * Keeps track of the cells that have been filled, using a bitmap for each
+ * block of 64x64 cells that has been touched. This keeps the memory usage
+ * proportional to the filled area rather than to the bounds of the layer.
+ */
+class FilledCells
+{
+public:
+    bool contains(int x, int y)
+    {
+        const quint64 key = blockKey(x, y);
+        if (!mLastBlock || key != mLastKey) {
+            const auto it = mBlocks.find(key);
+            if (it == mBlocks.end())
+                return false;
+
+            mLastBlock = &it->second;
+            mLastKey = key;
+        }
+        return mLastBlock->test(bitIndex(x, y));
+    }
+
+    void insert(int x, int y)
+    {
+        const quint64 key = blockKey(x, y);
+        if (!mLastBlock || key != mLastKey) {
+            mLastBlock = &mBlocks[key];
+            mLastKey = key;
+        }
+        mLastBlock->set(bitIndex(x, y));
+    }
+
+private:
+    static constexpr int BLOCK_BITS = 6;
+    static constexpr int BLOCK_MASK = (1 << BLOCK_BITS) - 1;
+
+    using Block = std::bitset<1 << (BLOCK_BITS * 2)>;
+
+    static quint64 blockKey(int x, int y)
+    {
+        return quint64(quint32(x >> BLOCK_BITS)) << 32 | quint32(y >> BLOCK_BITS);
+    }
+
+    static int bitIndex(int x, int y)
+    {
+        return (x & BLOCK_MASK) | (y & BLOCK_MASK) << BLOCK_BITS;
+    }
+
+    std::unordered_map<quint64, Block> mBlocks;
+    Block *mLastBlock = nullptr;
+    quint64 mLastKey = 0;
+};
+
+} // anonymous namespace
+
+/**
+ * Computes the region of connected cells matching the cell at \a fillOrigin,
+ * within the bounding rect of \a region.
+ *
+ * Uses a scanline fill with a stack of seed positions. Each seed is extended
+ * to the left and right into a span, after which the rows above and below the
+ * span are scanned for new seeds.
+ */
 static QRegion fillRegion(const TileLayer *layer,
                           const QRegion &region,
                           QPoint fillOrigin,
@@ -201,44 +272,58 @@ static QRegion fillRegion(const TileLayer *layer,
     const Cell matchCell = layer->cellAt(fillOrigin);
 
     const QRect bounds = region.boundingRect();
-    const int width = bounds.width();
-    const int height = bounds.height();
-    const int indexOffset = -(bounds.left() + bounds.top() * width);
-
     const bool isStaggered = orientation == Map::Hexagonal || orientation == Map::Staggered;
 
-    // Create a queue to hold cells that need filling
-    QQueue<QPoint> fillPositions;
-    fillPositions.enqueue(fillOrigin);
+    std::vector<QPoint> seeds;
+    seeds.push_back(fillOrigin);
+
+    FilledCells filled;
+    std::vector<Span> spans;
 
-    // Create an array that will store which cells have been processed
-    // This is faster than checking if a given cell is in the region/list
-    QVector<bool> processedCellsVec(width * height);
-    bool *processedCells = processedCellsVec.data();
-    QRegion fillRegion;
+    auto canFill = [&] (int x, int y) {
+        return !filled.contains(x, y) && layer->cellAt(x, y) == matchCell;
+    };
 
-    // Loop through queued positions and fill them, while at the same time
-    // checking adjacent positions to see if they should be added
-    while (!fillPositions.isEmpty()) {
-        const QPoint currentPoint = fillPositions.dequeue();
-        const int startOfLine = currentPoint.y() * width;
+    // Scans the cells between left and right on the given row, pushing a seed
+    // for each run of cells that still needs to be filled.
+    auto findFillPositions = [&] (int left, int right, int y) {
+        bool adjacentCellAdded = false;
 
-        // Seek as far left as we can
+        for (int x = left; x <= right; ++x) {
+            if (canFill(x, y)) {
+                if (!adjacentCellAdded) {
+                    seeds.push_back(QPoint(x, y));
+                    adjacentCellAdded = true;
+                }
+            } else {
+                adjacentCellAdded = false;
+            }
+        }
+    };
+
+    while (!seeds.empty()) {
+        const QPoint currentPoint = seeds.back();
+        seeds.pop_back();
+
+        const int y = currentPoint.y();
+
+        // The seed may have been filled as part of another span already
+        if (filled.contains(currentPoint.x(), y))
+            continue;
+
+        // Seek as far left and right as we can
         int left = currentPoint.x();
-        while (left > bounds.left() && layer->cellAt(left - 1, currentPoint.y()) == matchCell) {
+        while (left > bounds.left() && canFill(left - 1, y))
             --left;
-            processedCells[indexOffset + startOfLine + left] = true;
-        }
 
-        // Seek as far right as we can
         int right = currentPoint.x();
-        while (right < bounds.right() && layer->cellAt(right + 1, currentPoint.y()) == matchCell) {
+        while (right < bounds.right() && canFill(right + 1, y))
             ++right;
-            processedCells[indexOffset + startOfLine + right] = true;
-        }
 
-        // Add cells between left and right to the region
-        fillRegion += QRegion(left, currentPoint.y(), right - left + 1, 1);
+        for (int x = left; x <= right; ++x)
+            filled.insert(x, y);
+
+        spans.push_back(Span { y, left, right });
 
         bool leftColumnIsStaggered = false;
         bool rightColumnIsStaggered = false;
@@ -246,7 +331,7 @@ static QRegion fillRegion(const TileLayer *layer,
         // For hexagonal maps with a staggered Y-axis, we may need to extend the search range
         if (isStaggered) {
             if (staggerAxis == Map::StaggerY) {
-                bool rowIsStaggered = ((layer->y() + currentPoint.y()) & 1) ^ staggerIndex;
+                bool rowIsStaggered = ((layer->y() + y) & 1) ^ staggerIndex;
                 if (rowIsStaggered)
                     right = qMin(right + 1, bounds.right());
                 else
@@ -257,29 +342,7 @@ static QRegion fillRegion(const TileLayer *layer,
             }
         }
 
-        // Loop between left and right and check if cells above or below need
-        // to be added to the queue.
-        auto findFillPositions = [=,&fillPositions](int left, int right, int y) {
-            bool adjacentCellAdded = false;
-
-            for (int x = left; x <= right; ++x) {
-                const int index = y * width + x;
-
-                if (!processedCells[indexOffset + index] && layer->cellAt(x, y) == matchCell) {
-                    // Do not add the cell to the queue if an adjacent cell was added.
-                    if (!adjacentCellAdded) {
-                        fillPositions.enqueue(QPoint(x, y));
-                        adjacentCellAdded = true;
-                    }
-                } else {
-                    adjacentCellAdded = false;
-                }
-
-                processedCells[indexOffset + index] = true;
-            }
-        };
-
-        if (currentPoint.y() > bounds.top()) {
+        if (y > bounds.top()) {
             int _left = left;
             int _right = right;
 
@@ -290,10 +353,10 @@ static QRegion fillRegion(const TileLayer *layer,
                     _right = qMin(right + 1, bounds.right());
             }
 
-            findFillPositions(_left, _right, currentPoint.y() - 1);
+            findFillPositions(_left, _right, y - 1);
         }
 
-        if (currentPoint.y() < bounds.bottom()) {
+        if (y < bounds.bottom()) {
             int _left = left;
             int _right = right;
 
@@ -304,11 +367,11 @@ static QRegion fillRegion(const TileLayer *layer,
                     _right = qMin(right + 1, bounds.right());
             }
 
-            findFillPositions(_left, _right, currentPoint.y() + 1);
+            findFillPositions(_left, _right, y + 1);
         }
     }
 
-    return fillRegion;
+    return regionFromSpans(spans);
 }
 
 QRegion TilePainter::computePaintableFillRegion(QPoint fillOrigin) const
@@ -21,7 +21,11 @@
 
 #include "undodock.h"
 
+#include "undomemorylimiter.h"
+
 #include <QEvent>
+#include <QLabel>
+#include <QLocale>
 #include <QUndoView>
 #include <QVBoxLayout>
 
@@ -37,10 +41,16 @@ UndoDock::UndoDock(QWidget *parent)
     mUndoView->setCleanIcon(cleanIcon);
     mUndoView->setUniformItemSizes(true);
 
+    mMemoryUsageLabel = new QLabel(this);
+    mMemoryUsageLabel->setContentsMargins(4, 2, 4, 2);
+    mMemoryUsageLabel->setVisible(false);
+
     QWidget *widget = new QWidget(this);
     QVBoxLayout *layout = new QVBoxLayout(widget);
     layout->setContentsMargins(0, 0, 0, 0);
+    layout->setSpacing(0);
     layout->addWidget(mUndoView);
+    layout->addWidget(mMemoryUsageLabel);
 
     setWidget(widget);
     retranslateUi();
@@ -49,6 +59,22 @@ UndoDock::UndoDock(QWidget *parent)
 void UndoDock::setStack(QUndoStack *stack)
 {
     mUndoView->setStack(stack);
+
+    UndoMemoryLimiter *memoryLimiter = UndoMemoryLimiter::forStack(stack);
+    if (mMemoryLimiter == memoryLimiter)
+        return;
+
+    if (mMemoryLimiter)
+        mMemoryLimiter->disconnect(this);
+
+    mMemoryLimiter = memoryLimiter;
+
+    if (memoryLimiter) {
+        connect(memoryLimiter, &UndoMemoryLimiter::memoryUsageChanged,
+                this, &UndoDock::updateMemoryUsage);
+    }
+
+    updateMemoryUsage();
 }
 
 void UndoDock::changeEvent(QEvent *e)
@@ -67,6 +93,19 @@ void UndoDock::retranslateUi()
 {
     setWindowTitle(tr("History"));
     mUndoView->setEmptyLabel(tr("<empty>"));
+    updateMemoryUsage();
+}
+
+void UndoDock::updateMemoryUsage()
+{
+    mMemoryUsageLabel->setVisible(!mMemoryLimiter.isNull());
+    if (!mMemoryLimiter)
+        return;
+
+    const QLocale locale;
+    mMemoryUsageLabel->setText(tr("Tile changes: %1 of %2")
+                               .arg(locale.formattedDataSize(mMemoryLimiter->memoryUsage()),
+                                    locale.formattedDataSize(UndoMemoryLimiter::memoryLimit())));
 }
 
 #include "moc_undodock.cpp"
@@ -22,12 +22,16 @@
 #pragma once
 
 #include <QDockWidget>
+#include <QPointer>
 
+class QLabel;
 class QUndoStack;
 class QUndoView;
 
 namespace Tiled {
 
+class UndoMemoryLimiter;
+
 /**
  * A dock widget showing the undo stack. Mainly for debugging, but can also be
  * useful for the user.
@@ -46,7 +50,11 @@ protected:
 
 private:
     void retranslateUi();
+    void updateMemoryUsage();
+
     QUndoView *mUndoView;
+    QLabel *mMemoryUsageLabel;
+    QPointer<UndoMemoryLimiter> mMemoryLimiter;
 };
 
 } // namespace Tiled
@@ -0,0 +1,133 @@
+/*
+ * undomemorylimiter.cpp
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "undomemorylimiter.h"
+
+#include "painttilelayer.h"
+#include "undocommands.h"
+
+#include <QUndoStack>
+#include <QVector>
+
+using namespace Tiled;
+
+// The snapshots of commands this close to the current index are left
+// uncompressed, since they are likely to be undone or redone soon.
+static constexpr int recentCommandCount = 8;
+
+static qint64 sMemoryLimit = qint64(1024) * 1024 * 1024;
+static QVector<UndoMemoryLimiter*> sLimiters;
+
+static void collectPaintCommands(const QUndoCommand *command,
+                                 QVector<PaintTileLayer*> &paintCommands)
+{
+    // The commands are owned by the stack, which only provides const access
+    if (command->id() == Cmd_PaintTileLayer)
+        paintCommands.append(static_cast<PaintTileLayer*>(const_cast<QUndoCommand*>(command)));
+
+    for (int i = 0; i < command->childCount(); ++i)
+        collectPaintCommands(command->child(i), paintCommands);
+}
+
+UndoMemoryLimiter::UndoMemoryLimiter(QUndoStack *stack)
+    : QObject(stack)
+    , mStack(stack)
+{
+    connect(stack, &QUndoStack::indexChanged, this, &UndoMemoryLimiter::limit);
+    sLimiters.append(this);
+}
+
+UndoMemoryLimiter::~UndoMemoryLimiter()
+{
+    sLimiters.removeOne(this);
+}
+
+/**
+ * Returns the limiter installed on the given \a stack, if any.
+ */
+UndoMemoryLimiter *UndoMemoryLimiter::forStack(const QUndoStack *stack)
+{
+    if (!stack)
+        return nullptr;
+    return stack->findChild<UndoMemoryLimiter*>(QString(), Qt::FindDirectChildrenOnly);
+}
+
+/**
+ * Returns the maximum number of bytes the snapshots in each undo stack
+ * should use.
+ */
+qint64 UndoMemoryLimiter::memoryLimit()
+{
+    return sMemoryLimit;
+}
+
+/**
+ * Sets the memory limit and applies it to all undo stacks right away.
+ */
+void UndoMemoryLimiter::setMemoryLimit(qint64 bytes)
+{
+    if (sMemoryLimit == bytes)
+        return;
+
+    sMemoryLimit = bytes;
+
+    for (UndoMemoryLimiter *limiter : std::as_const(sLimiters))
+        limiter->limit();
+}
+
+void UndoMemoryLimiter::limit()
+{
+    const int index = mStack->index();
+    QVector<PaintTileLayer*> paintCommands;
+    qint64 usage = 0;
+
+    for (int i = 0; i < mStack->count(); ++i) {
+        paintCommands.clear();
+        collectPaintCommands(mStack->command(i), paintCommands);
+
+        const bool recent = i >= index - recentCommandCount && i < index + recentCommandCount;
+
+        for (PaintTileLayer *command : std::as_const(paintCommands)) {
+            if (!recent)
+                command->compress();
+            usage += command->memoryUsage();
+        }
+    }
+
+    // Discard the oldest snapshots until the history fits within the limit.
+    // Only commands that can be undone are discarded, since discarded
+    // commands can't be redone.
+    for (int i = 0; usage > sMemoryLimit && i < index - recentCommandCount; ++i) {
+        paintCommands.clear();
+        collectPaintCommands(mStack->command(i), paintCommands);
+
+        for (PaintTileLayer *command : std::as_const(paintCommands)) {
+            usage -= command->memoryUsage();
+            command->discard();
+        }
+    }
+
+    if (mMemoryUsage != usage) {
+        mMemoryUsage = usage;
+        emit memoryUsageChanged(usage);
+    }
+}
+
+#include "moc_undomemorylimiter.cpp"
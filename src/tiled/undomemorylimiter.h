@@ -0,0 +1,62 @@
+/*
+ * undomemorylimiter.h
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <QObject>
+
+class QUndoStack;
+
+namespace Tiled {
+
+/**
+ * Limits the memory used by the tile layer snapshots kept in an undo stack.
+ *
+ * Commands further away from the current index than a few steps get their
+ * snapshots compressed. When the history still uses more than the memory
+ * limit, the snapshots of the oldest commands are discarded, after which
+ * those commands can no longer be undone.
+ */
+class UndoMemoryLimiter : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit UndoMemoryLimiter(QUndoStack *stack);
+    ~UndoMemoryLimiter() override;
+
+    static UndoMemoryLimiter *forStack(const QUndoStack *stack);
+
+    qint64 memoryUsage() const { return mMemoryUsage; }
+
+    static qint64 memoryLimit();
+    static void setMemoryLimit(qint64 bytes);
+
+signals:
+    void memoryUsageChanged(qint64 bytes);
+
+private:
+    void limit();
+
+    QUndoStack *mStack;
+    qint64 mMemoryUsage = 0;
+};
+
+} // namespace Tiled
@@ -29,8 +29,21 @@
 #include "tilelayer.h"
 #include "wangset.h"
 
+#include <QSet>
+#include <QtConcurrent>
+
+#include <algorithm>
+
 using namespace Tiled;
 
+// Large regions are filled in blocks of BLOCK_SIZE x BLOCK_SIZE tiles, of
+// which the last row and column are left for a final serial pass.
+static constexpr int BLOCK_BITS = 6;
+static constexpr int BLOCK_SIZE = 1 << BLOCK_BITS;
+static constexpr int BLOCK_MASK = BLOCK_SIZE - 1;
+
+static constexpr qint64 minimumBatchedArea = 128 * 128;
+
 static constexpr QPoint aroundTilePoints[WangId::NumIndexes] = {
     QPoint( 0, -1),
     QPoint( 1, -1),
@@ -182,12 +195,27 @@ static void updateAdjacent(WangFiller::CellInfo &adjacentInfo, WangId wangId, in
     }
 }
 
+static qint64 regionArea(const QRegion &region)
+{
+    qint64 area = 0;
+    for (const QRect &rect : region)
+        area += qint64(rect.width()) * rect.height();
+    return area;
+}
+
 /**
  * Applies the scheduled Wang changes to the \a target layer.
+ *
+ * When no corrections are made and the region is large, the region is filled
+ * in blocks that are resolved in parallel. The blocks are separated by seams
+ * of one tile wide, which are resolved afterwards to connect the blocks.
+ * Random choices are derived from a seed and the location, so the result
+ * does not depend on the number of threads.
  */
 void WangFiller::apply(TileLayer &target)
 {
     mInvalidRegion = QRegion();
+    mRandomSeed = globalRandomEngine()();
 
     auto &grid = mFillRegion.grid;
     auto &region = mFillRegion.region;
@@ -245,21 +273,22 @@ void WangFiller::apply(TileLayer &target)
     // Keep a list of points that need correction
     QVector<QPoint> corrections;
 
-    auto resolve = [&] (int x, int y) {
-        const QPoint targetPos(x - target.x(),
-                               y - target.y());
+    auto resolve = [&] (TileLayer &layer, Grid<CellInfo> &cells, QRegion &invalidRegion,
+                        int x, int y) {
+        const QPoint targetPos(x - layer.x(),
+                               y - layer.y());
 
-        if (target.cellAt(targetPos).checked())
+        if (layer.cellAt(targetPos).checked())
             return;
 
         Cell cell;
-        if (!findBestMatch(target, grid, QPoint(x, y), cell)) {
-            mInvalidRegion += QRect(x, y, 1, 1);
+        if (!findBestMatch(layer, cells, QPoint(x, y), cell)) {
+            invalidRegion += QRect(x, y, 1, 1);
             return;
         }
 
         cell.setChecked(true);
-        target.setCell(targetPos.x(), targetPos.y(), cell);
+        layer.setCell(targetPos.x(), targetPos.y(), cell);
 
         const WangId cellWangId = mWangSet.wangIdOfCell(cell);
 
@@ -269,10 +298,10 @@ void WangFiller::apply(TileLayer &target)
 
         for (int i = 0; i < WangId::NumIndexes; ++i) {
             const QPoint p = adjacentPoints[i];
-            if (target.cellAt(p - target.position()).checked())
+            if (layer.cellAt(p - layer.position()).checked())
                 continue;
 
-            CellInfo &adjacentInfo = grid.add(p);
+            CellInfo &adjacentInfo = cells.add(p);
             updateAdjacent(adjacentInfo, cellWangId, i);
 
             // Check if we may need to reconsider a tile outside of our starting region
@@ -291,11 +320,123 @@ void WangFiller::apply(TileLayer &target)
         }
     };
 
-    // First process the initial region
-    for (const QRect &rect : region) {
-        for (int y = rect.top(); y <= rect.bottom(); ++y)
-            for (int x = rect.left(); x <= rect.right(); ++x)
-                resolve(x, y);
+    const bool batched = !mCorrectionsEnabled && !mHexagonalRenderer &&
+            regionArea(region) >= minimumBatchedArea;
+
+    if (batched) {
+        struct Block
+        {
+            QRect interior;
+            QRegion region;
+            Grid<CellInfo> grid;
+            std::unique_ptr<TileLayer> layer;
+            QRegion invalidRegion;
+        };
+
+        QSet<QPoint> blockIndexes;
+        for (const QRect &rect : region)
+            for (int by = rect.top() >> BLOCK_BITS; by <= rect.bottom() >> BLOCK_BITS; ++by)
+                for (int bx = rect.left() >> BLOCK_BITS; bx <= rect.right() >> BLOCK_BITS; ++bx)
+                    blockIndexes.insert(QPoint(bx, by));
+
+        QVector<QPoint> sortedBlockIndexes(blockIndexes.begin(), blockIndexes.end());
+        std::sort(sortedBlockIndexes.begin(), sortedBlockIndexes.end(),
+                  [] (QPoint a, QPoint b) {
+            return a.y() < b.y() || (a.y() == b.y() && a.x() < b.x());
+        });
+
+        std::vector<Block> blocks;
+        for (const QPoint &index : std::as_const(sortedBlockIndexes)) {
+            const QRect interior(index.x() << BLOCK_BITS, index.y() << BLOCK_BITS,
+                                 BLOCK_MASK, BLOCK_MASK);
+            QRegion blockRegion = region & interior;
+            if (!blockRegion.isEmpty())
+                blocks.push_back(Block { interior, std::move(blockRegion), {}, nullptr, {} });
+        }
+
+        // Make sure the lazily computed parts of the WangSet are available
+        // before using it from multiple threads.
+        mWangSet.wangIdsAndCells();
+        mWangSet.maximumColorDistance();
+
+        // Each block is resolved on its own copy of the grid and the target
+        // layer, which includes the surrounding seams. The blocks don't touch
+        // each other, so they are independent of each other.
+        QtConcurrent::blockingMap(blocks, [&] (Block &block) {
+            block.layer = std::make_unique<TileLayer>(QString(), target.x(), target.y(), 0, 0);
+
+            const QRect surroundings = block.interior.adjusted(-1, -1, 1, 1);
+            for (int y = surroundings.top(); y <= surroundings.bottom(); ++y) {
+                for (int x = surroundings.left(); x <= surroundings.right(); ++x) {
+                    block.grid.set(x, y, grid.get(x, y));
+
+                    const Cell &cell = target.cellAt(x - target.x(), y - target.y());
+                    if (cell.checked())
+                        block.layer->setCell(x - target.x(), y - target.y(), cell);
+                }
+            }
+
+            for (const QRect &rect : block.region)
+                for (int y = rect.top(); y <= rect.bottom(); ++y)
+                    for (int x = rect.left(); x <= rect.right(); ++x)
+                        resolve(*block.layer, block.grid, block.invalidRegion, x, y);
+        });
+
+        // Merge the blocks in a fixed order, propagating the tiles placed at
+        // the edge of each block to the adjacent seams.
+        for (const Block &block : blocks) {
+            for (const QRect &rect : block.region) {
+                for (int y = rect.top(); y <= rect.bottom(); ++y) {
+                    for (int x = rect.left(); x <= rect.right(); ++x) {
+                        const Cell &cell = block.layer->cellAt(x - target.x(), y - target.y());
+                        if (!cell.checked())
+                            continue;
+
+                        target.setCell(x - target.x(), y - target.y(), cell);
+
+                        if (x != block.interior.left() && x != block.interior.right() &&
+                                y != block.interior.top() && y != block.interior.bottom())
+                            continue;
+
+                        const WangId cellWangId = mWangSet.wangIdOfCell(cell);
+
+                        for (int i = 0; i < WangId::NumIndexes; ++i) {
+                            const QPoint p = QPoint(x, y) + aroundTilePoints[i];
+                            if (block.interior.contains(p))
+                                continue;
+                            if (target.cellAt(p - target.position()).checked())
+                                continue;
+
+                            updateAdjacent(grid.add(p), cellWangId, i);
+                        }
+                    }
+                }
+            }
+
+            mInvalidRegion += block.invalidRegion;
+        }
+
+        // Resolve the seams between the blocks, taking into account the
+        // tiles placed on both sides
+        for (const QRect &rect : region) {
+            for (int y = rect.top(); y <= rect.bottom(); ++y) {
+                if ((y & BLOCK_MASK) == BLOCK_MASK) {
+                    for (int x = rect.left(); x <= rect.right(); ++x)
+                        resolve(target, grid, mInvalidRegion, x, y);
+                } else {
+                    const int firstSeam = rect.left() + ((BLOCK_MASK - rect.left()) & BLOCK_MASK);
+                    for (int x = firstSeam; x <= rect.right(); x += BLOCK_SIZE)
+                        resolve(target, grid, mInvalidRegion, x, y);
+                }
+            }
+        }
+    } else {
+        // First process the initial region
+        for (const QRect &rect : region) {
+            for (int y = rect.top(); y <= rect.bottom(); ++y)
+                for (int x = rect.left(); x <= rect.right(); ++x)
+                    resolve(target, grid, mInvalidRegion, x, y);
+        }
     }
 
     // Process each batch of added correction points while avoiding to move
@@ -304,7 +445,7 @@ void WangFiller::apply(TileLayer &target)
     while (!corrections.isEmpty()) {
         processing.swap(corrections);
         for (const QPoint &p : processing)
-            resolve(p.x(), p.y());
+            resolve(target, grid, mInvalidRegion, p.x(), p.y());
         processing.clear();
     }
 
@@ -430,16 +571,22 @@ bool WangFiller::findBestMatch(const TileLayer &target,
         }
     };
 
+    // Only the candidates matching the masked WangId need to be considered
+    const auto &candidates = mWangSet.wangIdsAndCellsMatching(info.desired, info.mask);
     const auto &wangIdsAndCells = mWangSet.wangIdsAndCells();
-    for (int i = 0, i_end = wangIdsAndCells.size(); i < i_end; ++i)
+    for (const int i : candidates)
         processCandidate(wangIdsAndCells[i].wangId, wangIdsAndCells[i].cell);
 
     if (mErasingEnabled)
         processCandidate(WangId(), Cell());
 
     // Choose a candidate at random, with consideration for probability
+    SeededRandom random({ mRandomSeed,
+                          quint32(position.x()),
+                          quint32(position.y()) });
+
     while (!matches.isEmpty()) {
-        result = matches.take();
+        result = matches.take(random);
 
         // Check if we will be able to place any Wang tile next to this
         // candidate. This can be a relatively expensive check, that we'll only
@@ -111,6 +111,7 @@ private:
     const HexagonalRenderer * const mHexagonalRenderer;
     bool mCorrectionsEnabled = false;
     bool mErasingEnabled = true;
+    quint64 mRandomSeed = 0;
     FillRegion mFillRegion;
     QRegion mInvalidRegion;
 
@@ -20,10 +20,13 @@
  * this program. If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include "automapper.h"
+#include "automappingmanager.h"
 #include "commandlineparser.h"
 #include "exporthelper.h"
 #include "logginginterface.h"
 #include "mainwindow.h"
+#include "mapdocument.h"
 #include "mapformat.h"
 #include "pluginmanager.h"
 #include "preferences.h"
@@ -35,10 +38,12 @@
 #include "tmxmapformat.h"
 
 #include <QDebug>
+#include <QFile>
 #include <QFileInfo>
 #include <QImageReader>
 #include <QJsonArray>
 #include <QJsonDocument>
+#include <QJsonObject>
 #include <QtPlugin>
 
 #include "qtcompat_p.h"
@@ -85,8 +90,11 @@ public:
     bool disableOpenGL = false;
     bool exportMap = false;
     bool exportTileset = false;
+    bool autoMap = false;
     bool newInstance = false;
     Preferences::ExportOptions exportOptions;
+    QString autoMapRulesFile;
+    QString autoMapProfileFile;
 
 private:
     void showVersion();
@@ -100,6 +108,9 @@ private:
     void setExportMinimized();
     void showExportFormats();
     void setCompatibilityVersion();
+    void setAutoMap();
+    void setAutoMapRulesFile();
+    void setAutoMapProfileFile();
     void evaluateScript();
     void startNewInstance();
 
@@ -172,6 +183,97 @@ inline T *findExportFormat(const QString *filter,
     return outputFormat;
 }
 
+static QJsonObject toJson(const RulesMapProfile &profile)
+{
+    auto ms = [] (qint64 nanoseconds) { return nanoseconds / 1000000.0; };
+
+    QJsonArray rules;
+    for (const RuleProfile &rule : profile.rules) {
+        rules.append(QJsonObject {
+            { QStringLiteral("x"), rule.bounds.x() },
+            { QStringLiteral("y"), rule.bounds.y() },
+            { QStringLiteral("width"), rule.bounds.width() },
+            { QStringLiteral("height"), rule.bounds.height() },
+            { QStringLiteral("positionsTested"), rule.positionsTested },
+            { QStringLiteral("matches"), rule.matches },
+            { QStringLiteral("appliedOutputs"), rule.appliedOutputs },
+            { QStringLiteral("matchTimeMs"), ms(rule.matchTime) },
+            { QStringLiteral("applyTimeMs"), ms(rule.applyTime) },
+        });
+    }
+
+    return QJsonObject {
+        { QStringLiteral("rulesFile"), profile.rulesMapFileName },
+        { QStringLiteral("setupTimeMs"), ms(profile.setupTime) },
+        { QStringLiteral("compileTimeMs"), ms(profile.compileTime) },
+        { QStringLiteral("wallTimeMs"), ms(profile.wallTime) },
+        { QStringLiteral("rules"), rules },
+    };
+}
+
+/**
+ * Applies AutoMapping to the entire map stored in \a fileName and saves it
+ * when it was changed. Uses the rules file associated with the map, unless
+ * a \a rulesFile is given.
+ *
+ * When \a profiles is given, the profiling statistics are added to it.
+ */
+static bool autoMapFile(AutomappingManager &manager,
+                        const QString &fileName,
+                        const QString &rulesFile,
+                        QJsonArray *profiles)
+{
+    MapFormat *format = findSupportingMapFormat(fileName);
+    if (!format) {
+        qWarning().noquote() << QCoreApplication::translate("Command line", "Unrecognized map format: %1").arg(fileName);
+        return false;
+    }
+
+    QString errorMsg;
+    const MapDocumentPtr mapDocument = MapDocument::load(fileName, format, &errorMsg);
+    if (!mapDocument) {
+        qWarning().noquote() << QCoreApplication::translate("Command line", "Failed to load map '%1'.").arg(fileName);
+        if (!errorMsg.isEmpty())
+            qWarning().noquote() << errorMsg;
+        return false;
+    }
+
+    manager.setMapDocument(mapDocument.data(), rulesFile);
+    manager.autoMap();
+    manager.setMapDocument(nullptr, rulesFile);
+
+    if (profiles) {
+        QJsonArray rulesMaps;
+        for (const RulesMapProfile &profile : manager.profiles())
+            rulesMaps.append(toJson(profile));
+
+        profiles->append(QJsonObject {
+            { QStringLiteral("map"), fileName },
+            { QStringLiteral("rulesMaps"), rulesMaps },
+        });
+    }
+
+    if (!manager.warningString().isEmpty())
+        qWarning().noquote() << manager.warningString().trimmed();
+
+    if (!manager.errorString().isEmpty()) {
+        qWarning().noquote() << QCoreApplication::translate("Command line", "Failed to apply AutoMapping to '%1'.").arg(fileName);
+        qWarning().noquote() << manager.errorString().trimmed();
+        return false;
+    }
+
+    if (!mapDocument->isModified())
+        return true;
+
+    if (!mapDocument->save(fileName, &errorMsg)) {
+        qWarning().noquote() << QCoreApplication::translate("Command line", "Failed to save map '%1'.").arg(fileName);
+        if (!errorMsg.isEmpty())
+            qWarning().noquote() << errorMsg;
+        return false;
+    }
+
+    return true;
+}
 
 } // anonymous namespace
 
@@ -233,6 +335,21 @@ CommandLineHandler::CommandLineHandler()
                 QLatin1String("--minimize"),
                 tr("Minimize the exported file by omitting unnecessary whitespace"));
 
+    option<&CommandLineHandler::setAutoMap>(
+                QChar(),
+                QLatin1String("--automap"),
+                tr("Apply AutoMapping to the specified map files and save them"));
+
+    option<&CommandLineHandler::setAutoMapRulesFile>(
+                QChar(),
+                QLatin1String("--automap-rules"),
+                tr("Set the rules file used by --automap"));
+
+    option<&CommandLineHandler::setAutoMapProfileFile>(
+                QChar(),
+                QLatin1String("--automap-profile"),
+                tr("Write AutoMapping statistics per rule to the given JSON file"));
+
     option<&CommandLineHandler::startNewInstance>(
                 QChar(),
                 QLatin1String("--new-instance"),
@@ -343,6 +460,29 @@ void CommandLineHandler::setCompatibilityVersion()
     FileFormat::setCompatibilityVersion(version);
 }
 
+void CommandLineHandler::setAutoMap()
+{
+    autoMap = true;
+}
+
+void CommandLineHandler::setAutoMapRulesFile()
+{
+    autoMapRulesFile = nextArgument();
+    if (autoMapRulesFile.isEmpty()) {
+        qWarning().noquote() << QCoreApplication::translate("Command line", "Missing argument, set rules file using: --automap-rules <rules-file>");
+        justQuit();
+    }
+}
+
+void CommandLineHandler::setAutoMapProfileFile()
+{
+    autoMapProfileFile = nextArgument();
+    if (autoMapProfileFile.isEmpty()) {
+        qWarning().noquote() << QCoreApplication::translate("Command line", "Missing argument, set profile file using: --automap-profile <json-file>");
+        justQuit();
+    }
+}
+
 void CommandLineHandler::evaluateScript()
 {
     justQuit(); // always quit after running the script
@@ -539,6 +679,41 @@ int main(int argc, char *argv[])
         return 0;
     }
 
+    if (commandLine.autoMap) {
+        if (commandLine.filesToOpen().isEmpty()) {
+            qWarning().noquote() << QCoreApplication::translate("Command line", "AutoMap syntax is --automap [--automap-rules <rules-file>] [--automap-profile <json-file>] <map>...");
+            return 1;
+        }
+
+        initializePluginsAndExtensions();
+
+        // The maps are processed one after the other, since loading and
+        // saving maps relies on shared state. The rule maps are only loaded
+        // once and the rules are matched in parallel.
+        AutomappingManager manager;
+        bool success = true;
+
+        const bool profiling = !commandLine.autoMapProfileFile.isEmpty();
+        manager.setProfilingEnabled(profiling);
+        QJsonArray profiles;
+
+        for (const QString &fileName : commandLine.filesToOpen()) {
+            success &= autoMapFile(manager, fileName, commandLine.autoMapRulesFile,
+                                   profiling ? &profiles : nullptr);
+        }
+
+        if (profiling) {
+            QFile file(commandLine.autoMapProfileFile);
+            if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+                qWarning().noquote() << QCoreApplication::translate("Command line", "Failed to write profile to '%1'.").arg(commandLine.autoMapProfileFile);
+                return 1;
+            }
+            file.write(QJsonDocument(profiles).toJson());
+        }
+
+        return success ? 0 : 1;
+    }
+
     QStringList filesToOpen;
 
     for (const QString &fileName : commandLine.filesToOpen()) {
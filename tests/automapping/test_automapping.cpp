@@ -69,7 +69,7 @@ void test_AutoMapping::autoMap()
 
     autoMapper.prepareAutoMap(context);
     QBENCHMARK {
-        autoMapper.autoMap(region, nullptr, context);  // todo: test appliedRegion as well
+        autoMapper.autoMap(region, context);
     }
 
     // Apply the changes done by AutoMapping (only checking tile layers for now)
@@ -0,0 +1,295 @@
+#include "map.h"
+#include "tilelayer.h"
+#include "tileset.h"
+
+#include "automapper.h"
+#include "mapdocument.h"
+
+#include <QScopeGuard>
+#include <QThreadPool>
+#include <QtTest/QtTest>
+
+#include <cmath>
+#include <random>
+
+using namespace Tiled;
+
+namespace {
+
+constexpr int groundTileCount = 4;
+constexpr int decorTileCount = 16;
+
+SharedTileset createTileset()
+{
+    auto tileset = Tileset::create(QStringLiteral("tiles"), 16, 16);
+    for (int id = 0; id < groundTileCount + decorTileCount; ++id)
+        tileset->findOrCreateTile(id);
+    return tileset;
+}
+
+/**
+ * Creates a map with a "ground" layer filled with random ground tiles and an
+ * empty "decor" layer, which is the output layer of the generated rules.
+ */
+std::unique_ptr<Map> createMap(const SharedTileset &tileset, int size,
+                               std::mt19937 &random)
+{
+    Map::Parameters parameters;
+    parameters.width = size;
+    parameters.height = size;
+    parameters.tileWidth = 16;
+    parameters.tileHeight = 16;
+
+    auto map = std::make_unique<Map>(parameters);
+    map->addTileset(tileset);
+
+    auto ground = std::make_unique<TileLayer>(QStringLiteral("ground"), 0, 0, size, size);
+    std::uniform_int_distribution<int> groundTile(0, groundTileCount - 1);
+    for (int y = 0; y < size; ++y)
+        for (int x = 0; x < size; ++x)
+            ground->setCell(x, y, Cell(tileset->findTile(groundTile(random))));
+
+    map->addLayer(std::move(ground));
+    map->addLayer(std::make_unique<TileLayer>(QStringLiteral("decor"), 0, 0, size, size));
+
+    return map;
+}
+
+/**
+ * Creates a rules map with \a ruleCount random 2x2 rules, each having two
+ * possible outputs.
+ */
+std::unique_ptr<Map> createRulesMap(const SharedTileset &tileset, int ruleCount,
+                                    std::mt19937 &random)
+{
+    // The rules are placed in a grid, with one tile of space between them
+    const int columns = static_cast<int>(std::ceil(std::sqrt(ruleCount)));
+    const int rows = (ruleCount + columns - 1) / columns;
+    const int width = columns * 3;
+    const int height = rows * 3;
+
+    Map::Parameters parameters;
+    parameters.width = width;
+    parameters.height = height;
+    parameters.tileWidth = 16;
+    parameters.tileHeight = 16;
+
+    auto rulesMap = std::make_unique<Map>(parameters);
+    rulesMap->addTileset(tileset);
+    rulesMap->setProperty(QStringLiteral("RandomSeed"), 1);
+
+    auto input = std::make_unique<TileLayer>(QStringLiteral("input_ground"), 0, 0, width, height);
+    auto output1 = std::make_unique<TileLayer>(QStringLiteral("output1_decor"), 0, 0, width, height);
+    auto output2 = std::make_unique<TileLayer>(QStringLiteral("output2_decor"), 0, 0, width, height);
+
+    std::uniform_int_distribution<int> groundTile(0, groundTileCount - 1);
+    std::uniform_int_distribution<int> decorTile(groundTileCount, groundTileCount + decorTileCount - 1);
+
+    for (int i = 0; i < ruleCount; ++i) {
+        const int x = (i % columns) * 3;
+        const int y = (i / columns) * 3;
+
+        for (int dy = 0; dy < 2; ++dy)
+            for (int dx = 0; dx < 2; ++dx)
+                input->setCell(x + dx, y + dy, Cell(tileset->findTile(groundTile(random))));
+
+        output1->setCell(x, y, Cell(tileset->findTile(decorTile(random))));
+        output2->setCell(x + 1, y + 1, Cell(tileset->findTile(decorTile(random))));
+    }
+
+    rulesMap->addLayer(std::move(input));
+    rulesMap->addLayer(std::move(output1));
+    rulesMap->addLayer(std::move(output2));
+
+    return rulesMap;
+}
+
+/**
+ * Memory used by the output of an AutoMapping run.
+ */
+struct OutputMemory
+{
+    int layerCount = 0;
+    int chunkCount = 0;
+
+    qint64 bytes() const
+    {
+        return qint64(chunkCount) * CHUNK_SIZE * CHUNK_SIZE * qint64(sizeof(Cell));
+    }
+};
+
+/**
+ * Applies the rules to the entire map and returns the resulting "decor"
+ * layer, without changing the map.
+ *
+ * When \a outputMemory is given, it is set to the memory used by the tile
+ * layers the run created in its AutoMappingContext.
+ */
+std::unique_ptr<TileLayer> applyRules(MapDocument &mapDocument,
+                                      AutoMapper &autoMapper,
+                                      std::vector<RulesMapProfile> *profiles = nullptr,
+                                      OutputMemory *outputMemory = nullptr)
+{
+    const Map *map = mapDocument.map();
+
+    AutoMappingContext context(&mapDocument);
+    context.profiles = profiles;
+
+    autoMapper.prepareAutoMap(context);
+    autoMapper.autoMap(QRect(QPoint(), map->size()), context);
+
+    if (outputMemory) {
+        *outputMemory = OutputMemory();
+
+        for (const auto &[original, output] : context.originalToOutputLayerMapping) {
+            ++outputMemory->layerCount;
+            outputMemory->chunkCount += output->chunkCount();
+        }
+        for (const auto &layer : context.newLayers) {
+            if (const TileLayer *tileLayer = layer->asTileLayer()) {
+                ++outputMemory->layerCount;
+                outputMemory->chunkCount += tileLayer->chunkCount();
+            }
+        }
+    }
+
+    auto decor = static_cast<TileLayer*>(map->layerAt(1));
+    auto it = context.originalToOutputLayerMapping.find(decor);
+    if (it == context.originalToOutputLayerMapping.end())
+        return std::unique_ptr<TileLayer>(decor->clone());
+
+    return std::move(it->second);
+}
+
+} // anonymous namespace
+
+class test_AutoMappingBenchmark : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void threadCountIndependence_data();
+    void threadCountIndependence();
+
+    void autoMap_data();
+    void autoMap();
+};
+
+void test_AutoMappingBenchmark::threadCountIndependence_data()
+{
+    QTest::addColumn<bool>("matchInOrder");
+    QTest::addColumn<bool>("noOverlappingOutput");
+    QTest::addColumn<double>("probability");
+
+    QTest::newRow("default") << false << false << 1.0;
+    QTest::newRow("match-in-order") << true << false << 1.0;
+    QTest::newRow("no-overlapping-output") << false << true << 1.0;
+    QTest::newRow("probability") << false << false << 0.5;
+    QTest::newRow("match-in-order-probability") << true << true << 0.5;
+}
+
+/**
+ * Verifies that the result does not depend on the number of threads in the
+ * pool, when a RandomSeed is set. Note that with a single thread the work is
+ * still split up in the same way, it is just not done concurrently.
+ */
+void test_AutoMappingBenchmark::threadCountIndependence()
+{
+    QFETCH(bool, matchInOrder);
+    QFETCH(bool, noOverlappingOutput);
+    QFETCH(double, probability);
+
+    std::mt19937 random(42);
+    const auto tileset = createTileset();
+
+    auto rulesMap = createRulesMap(tileset, 200, random);
+    rulesMap->setProperty(QStringLiteral("MatchInOrder"), matchInOrder);
+    rulesMap->setProperty(QStringLiteral("NoOverlappingOutput"), noOverlappingOutput);
+    rulesMap->setProperty(QStringLiteral("Probability"), probability);
+
+    MapDocument mapDocument(createMap(tileset, 512, random));
+    AutoMapper autoMapper(std::move(rulesMap));
+    QVERIFY(autoMapper.errorString().isEmpty());
+
+    QThreadPool *threadPool = QThreadPool::globalInstance();
+    const int maxThreadCount = threadPool->maxThreadCount();
+    auto restoreThreadCount = qScopeGuard([=] { threadPool->setMaxThreadCount(maxThreadCount); });
+
+    threadPool->setMaxThreadCount(1);
+    const auto expected = applyRules(mapDocument, autoMapper);
+    QVERIFY(!expected->isEmpty());
+
+    for (const int threadCount : { 2, std::max(4, QThread::idealThreadCount()) }) {
+        threadPool->setMaxThreadCount(threadCount);
+        const auto result = applyRules(mapDocument, autoMapper);
+
+        QCOMPARE(result->region(), expected->region());
+        QVERIFY(result->computeDiffRegion(*expected).isEmpty());
+    }
+}
+
+void test_AutoMappingBenchmark::autoMap_data()
+{
+    QTest::addColumn<int>("mapSize");
+    QTest::addColumn<int>("ruleCount");
+
+    // By default only small maps are used, to keep the test run short. The
+    // large maps take minutes and several GB of memory, so they are only
+    // included when requested.
+    QVector<int> mapSizes { 256 };
+    QVector<int> ruleCounts { 10, 100 };
+    if (qEnvironmentVariableIsSet("TILED_BENCHMARK_LARGE_MAPS")) {
+        mapSizes = { 1024, 2048, 4096, 8192 };
+        ruleCounts = { 10, 100, 1000 };
+    }
+
+    for (const int mapSize : std::as_const(mapSizes))
+        for (const int ruleCount : std::as_const(ruleCounts))
+            QTest::addRow("%dx%d-%d-rules", mapSize, mapSize, ruleCount) << mapSize << ruleCount;
+}
+
+void test_AutoMappingBenchmark::autoMap()
+{
+    QFETCH(int, mapSize);
+    QFETCH(int, ruleCount);
+
+    std::mt19937 random(mapSize + ruleCount);
+    const auto tileset = createTileset();
+
+    MapDocument mapDocument(createMap(tileset, mapSize, random));
+    AutoMapper autoMapper(createRulesMap(tileset, ruleCount, random));
+    QVERIFY(autoMapper.errorString().isEmpty());
+
+    // Report the throughput and the memory used by the output layers based
+    // on a profiled run
+    std::vector<RulesMapProfile> profiles;
+    OutputMemory outputMemory;
+    applyRules(mapDocument, autoMapper, &profiles, &outputMemory);
+    QCOMPARE(profiles.size(), size_t(1));
+
+    const RulesMapProfile &profile = profiles.front();
+    qint64 positionsTested = 0;
+    qint64 appliedOutputs = 0;
+    for (const RuleProfile &rule : profile.rules) {
+        positionsTested += rule.positionsTested;
+        appliedOutputs += rule.appliedOutputs;
+    }
+
+    const double seconds = std::max<qint64>(profile.wallTime, 1) / 1e9;
+    qInfo().noquote() << QStringLiteral("%1 positions tested (%2 M/s), %3 outputs applied (%4 M/s)")
+                         .arg(positionsTested)
+                         .arg(positionsTested / seconds / 1e6, 0, 'f', 1)
+                         .arg(appliedOutputs)
+                         .arg(appliedOutputs / seconds / 1e6, 0, 'f', 1);
+    qInfo().noquote() << QStringLiteral("%1 output layers with %2 chunks (%3 KiB)")
+                         .arg(outputMemory.layerCount)
+                         .arg(outputMemory.chunkCount)
+                         .arg(outputMemory.bytes() / 1024);
+
+    QBENCHMARK {
+        applyRules(mapDocument, autoMapper);
+    }
+}
+
+QTEST_MAIN(test_AutoMappingBenchmark)
+#include "test_automappingbenchmark.moc"
@@ -0,0 +1,108 @@
+#include "connectedcomponents.h"
+#include "tilelayer.h"
+#include "tileset.h"
+
+#include <QtTest/QtTest>
+
+using namespace Tiled;
+
+class test_ConnectedComponents : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+
+    void diagonalConnectivity();
+    void joinsBands();
+    void staggeredConnectivity();
+    void canceled();
+
+private:
+    SharedTileset mTileset;
+    Cell mCell;
+};
+
+void test_ConnectedComponents::initTestCase()
+{
+    mTileset = Tileset::create(QStringLiteral("tiles"), 16, 16);
+    mCell = Cell(mTileset->findOrCreateTile(0));
+}
+
+void test_ConnectedComponents::diagonalConnectivity()
+{
+    TileLayer layer(QStringLiteral("layer"), 0, 0, 3, 3);
+    layer.setCell(0, 0, mCell);
+    layer.setCell(1, 1, mCell);
+
+    const ConnectedComponents fourWay(layer, layer.rect(), ConnectedComponents::FourWay);
+    QCOMPARE(fourWay.count(), 3);
+    QCOMPARE(fourWay.labelAt(0, 0), 0);
+    QCOMPARE(fourWay.labelAt(1, 0), 1);
+    QCOMPARE(fourWay.labelAt(1, 1), 2);
+    QCOMPARE(fourWay.labelAt(2, 2), 1);
+
+    const ConnectedComponents eightWay(layer, layer.rect(), ConnectedComponents::EightWay);
+    QCOMPARE(eightWay.count(), 2);
+    QCOMPARE(eightWay.labelAt(1, 1), eightWay.labelAt(0, 0));
+    QCOMPARE(eightWay.region(0), QRegion(0, 0, 1, 1) + QRegion(1, 1, 1, 1));
+}
+
+/**
+ * The labeling is done in bands of rows, so components spanning several
+ * bands need to be joined.
+ */
+void test_ConnectedComponents::joinsBands()
+{
+    // A wall that only leaves a gap on the last row
+    TileLayer layer(QStringLiteral("layer"), 0, 0, 10, 200);
+    for (int y = 0; y < 199; ++y)
+        layer.setCell(5, y, mCell);
+
+    const ConnectedComponents components(layer, layer.rect());
+    QCOMPARE(components.count(), 2);
+    QCOMPARE(components.labelAt(0, 0), 0);
+    QCOMPARE(components.labelAt(5, 0), 1);
+    QCOMPARE(components.labelAt(9, 0), 0);
+    QCOMPARE(components.labelAt(5, 199), 0);
+    QCOMPARE(components.labelAt(10, 0), -1);
+
+    const QVector<QRegion> regions = components.regions();
+    QCOMPARE(regions.size(), 2);
+    QCOMPARE(regions.at(1), QRegion(5, 0, 1, 199));
+    QCOMPARE(regions.at(0), QRegion(layer.rect()) - regions.at(1));
+}
+
+void test_ConnectedComponents::staggeredConnectivity()
+{
+    // With odd rows staggered, the cell at (0, 1) touches (0, 0) and (1, 0)
+    TileLayer layer(QStringLiteral("layer"), 0, 0, 3, 2);
+    layer.setCell(1, 0, mCell);
+    layer.setCell(0, 1, mCell);
+
+    const ConnectedComponents components(layer, layer.rect(),
+                                         ConnectedComponents::Staggered,
+                                         Map::StaggerY, Map::StaggerOdd);
+    QCOMPARE(components.count(), 3);
+    QCOMPARE(components.labelAt(0, 0), 0);
+    QCOMPARE(components.labelAt(1, 0), 1);
+    QCOMPARE(components.labelAt(0, 1), 1);
+    QCOMPARE(components.labelAt(2, 0), 2);
+    QCOMPARE(components.labelAt(1, 1), 2);
+}
+
+void test_ConnectedComponents::canceled()
+{
+    TileLayer layer(QStringLiteral("layer"), 0, 0, 10, 200);
+
+    const ConnectedComponents components(layer, layer.rect(),
+                                         ConnectedComponents::FourWay,
+                                         Map::StaggerY, Map::StaggerOdd,
+                                         [] { return true; });
+    QCOMPARE(components.count(), 0);
+    QVERIFY(components.bounds().isEmpty());
+    QCOMPARE(components.labelAt(0, 0), -1);
+}
+
+QTEST_MAIN(test_ConnectedComponents)
+#include "test_connectedcomponents.moc"
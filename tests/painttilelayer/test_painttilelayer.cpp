@@ -0,0 +1,197 @@
+#include "map.h"
+#include "tilelayer.h"
+#include "tileset.h"
+
+#include "mapdocument.h"
+#include "painttilelayer.h"
+
+#include <QUndoStack>
+#include <QtTest/QtTest>
+
+using namespace Tiled;
+
+class test_PaintTileLayer : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+
+    void packCellsRoundTrip();
+    void compressRoundTrip();
+    void undoDiscarded();
+
+private:
+    std::unique_ptr<MapDocument> createMapDocument() const;
+    std::unique_ptr<TileLayer> createSource() const;
+
+    SharedTileset mTileset1;
+    SharedTileset mTileset2;
+};
+
+void test_PaintTileLayer::initTestCase()
+{
+    mTileset1 = Tileset::create(QStringLiteral("tiles1"), 16, 16);
+    mTileset2 = Tileset::create(QStringLiteral("tiles2"), 16, 16);
+    for (int id = 0; id < 4; ++id) {
+        mTileset1->findOrCreateTile(id);
+        mTileset2->findOrCreateTile(id);
+    }
+}
+
+std::unique_ptr<MapDocument> test_PaintTileLayer::createMapDocument() const
+{
+    Map::Parameters parameters;
+    parameters.width = 40;
+    parameters.height = 40;
+    parameters.tileWidth = 16;
+    parameters.tileHeight = 16;
+
+    auto map = std::make_unique<Map>(parameters);
+    map->addTileset(mTileset1);
+    map->addTileset(mTileset2);
+
+    auto layer = std::make_unique<TileLayer>(QStringLiteral("layer"), 0, 0, 40, 40);
+    for (int y = 0; y < 40; ++y)
+        for (int x = 0; x < 40; ++x)
+            layer->setCell(x, y, Cell(mTileset1->findTile((x + y) % 4)));
+    map->addLayer(std::move(layer));
+
+    return std::make_unique<MapDocument>(std::move(map));
+}
+
+/**
+ * Returns a layer with cells from both tilesets, using all the flags.
+ */
+std::unique_ptr<TileLayer> test_PaintTileLayer::createSource() const
+{
+    auto source = std::make_unique<TileLayer>(QStringLiteral("source"), 0, 0, 20, 20);
+
+    for (int y = 0; y < 20; ++y) {
+        for (int x = 0; x < 20; ++x) {
+            Cell cell((x + y) % 2 ? mTileset2.data() : mTileset1.data(), (x * y) % 4);
+            cell.setFlippedHorizontally(x % 2);
+            cell.setFlippedVertically(y % 2);
+            cell.setFlippedAntiDiagonally(x % 3 == 0);
+            cell.setRotatedHexagonal120(y % 3 == 0);
+            source->setCell(x, y, cell);
+        }
+    }
+
+    return source;
+}
+
+static void compareCells(const TileLayer &actual, const TileLayer &expected)
+{
+    QCOMPARE(actual.region(), expected.region());
+
+    const QRect bounds = expected.bounds().united(actual.bounds());
+    for (int y = bounds.top(); y <= bounds.bottom(); ++y) {
+        for (int x = bounds.left(); x <= bounds.right(); ++x) {
+            const Cell &a = actual.cellAt(x, y);
+            const Cell &e = expected.cellAt(x, y);
+            QCOMPARE(a.tileset(), e.tileset());
+            QCOMPARE(a.tileId(), e.tileId());
+            QCOMPARE(a.flippedHorizontally(), e.flippedHorizontally());
+            QCOMPARE(a.flippedVertically(), e.flippedVertically());
+            QCOMPARE(a.flippedAntiDiagonally(), e.flippedAntiDiagonally());
+            QCOMPARE(a.rotatedHexagonal120(), e.rotatedHexagonal120());
+            QCOMPARE(a.checked(), e.checked());
+        }
+    }
+}
+
+void test_PaintTileLayer::packCellsRoundTrip()
+{
+    const auto first = createSource();
+
+    // Empty cells are only kept when they are checked
+    Cell checkedEmpty;
+    checkedEmpty.setChecked(true);
+    first->setCell(3, 3, checkedEmpty);
+
+    Cell checkedTile(mTileset2.data(), 1);
+    checkedTile.setChecked(true);
+    first->setCell(4, 4, checkedTile);
+
+    // A second layer at negative coordinates, only using the second tileset
+    TileLayer second;
+    second.setCell(-20, -5, Cell(mTileset2.data(), 3));
+    second.setCell(17, -1, Cell(mTileset2.data(), 2));
+
+    QVector<SharedTileset> tilesets;
+    QVector<qint32> words;
+    packCells(*first, tilesets, words);
+    packCells(second, tilesets, words);
+
+    QCOMPARE(tilesets.size(), 2);
+    QVERIFY(tilesets.contains(mTileset1));
+    QVERIFY(tilesets.contains(mTileset2));
+
+    const qint32 *data = words.constData();
+    const auto unpackedFirst = unpackCells(data, tilesets);
+    const auto unpackedSecond = unpackCells(data, tilesets);
+    QVERIFY(data == words.constData() + words.size());
+
+    compareCells(*unpackedFirst, *first);
+    compareCells(*unpackedSecond, second);
+    QVERIFY(unpackedFirst->cellAt(3, 3).checked());
+}
+
+/**
+ * Verifies that undo and redo restore the same cells when the snapshots of
+ * the command were compressed.
+ */
+void test_PaintTileLayer::compressRoundTrip()
+{
+    const auto mapDocument = createMapDocument();
+    auto target = static_cast<TileLayer*>(mapDocument->map()->layerAt(0));
+    const std::unique_ptr<TileLayer> original(target->clone());
+
+    const auto source = createSource();
+    const QRegion paintRegion = QRegion(5, 5, 20, 20) - QRegion(10, 10, 4, 4);
+
+    auto command = new PaintTileLayer(mapDocument.get(), target, 5, 5,
+                                      source.get(), paintRegion);
+    mapDocument->undoStack()->push(command);
+    const std::unique_ptr<TileLayer> painted(target->clone());
+
+    const qint64 uncompressedUsage = command->memoryUsage();
+    command->compress();
+    QVERIFY(command->memoryUsage() < uncompressedUsage);
+
+    mapDocument->undoStack()->undo();
+    compareCells(*target, *original);
+
+    command->compress();
+    mapDocument->undoStack()->redo();
+    compareCells(*target, *painted);
+}
+
+/**
+ * Undoing a discarded command leaves the tiles changed, so the document must
+ * not be considered unmodified afterwards.
+ */
+void test_PaintTileLayer::undoDiscarded()
+{
+    const auto mapDocument = createMapDocument();
+    QUndoStack *undoStack = mapDocument->undoStack();
+    auto target = static_cast<TileLayer*>(mapDocument->map()->layerAt(0));
+
+    const auto source = createSource();
+    auto command = new PaintTileLayer(mapDocument.get(), target, 0, 0,
+                                      source.get(), QRegion(0, 0, 20, 20));
+    undoStack->push(command);
+    const std::unique_ptr<TileLayer> painted(target->clone());
+    QVERIFY(!undoStack->isClean());
+
+    command->discard();
+    undoStack->undo();
+
+    QCOMPARE(undoStack->count(), 0);
+    QVERIFY(!undoStack->isClean());
+    compareCells(*target, *painted);
+}
+
+QTEST_MAIN(test_PaintTileLayer)
+#include "test_painttilelayer.moc"
@@ -0,0 +1,570 @@
+#include "map.h"
+#include "tilelayer.h"
+#include "tileset.h"
+
+#include <QtTest/QtTest>
+
+#include <random>
+
+using namespace Tiled;
+
+/*
+ * The transformations of TileLayer are compared to reference
+ * implementations, which set the transformed cells one by one.
+ */
+
+namespace {
+
+struct CubeHex
+{
+    int x;
+    int y;
+    int z;
+};
+
+CubeHex hexFromStaggered(int col, int row,
+                         Map::StaggerIndex staggerIndex,
+                         Map::StaggerAxis staggerAxis)
+{
+    CubeHex hex;
+
+    if (staggerAxis == Map::StaggerX) {
+        hex.x = col;
+        if (staggerIndex == Map::StaggerEven)
+            hex.z = row - (col + (col & 1)) / 2;
+        else
+            hex.z = row - (col - (col & 1)) / 2;
+    } else {
+        hex.z = row;
+        if (staggerIndex == Map::StaggerEven)
+            hex.x = col - (row + (row & 1)) / 2;
+        else
+            hex.x = col - (row - (row & 1)) / 2;
+    }
+
+    hex.y = -hex.x - hex.z;
+    return hex;
+}
+
+QPoint hexToStaggered(CubeHex hex,
+                      Map::StaggerIndex staggerIndex,
+                      Map::StaggerAxis staggerAxis)
+{
+    if (staggerAxis == Map::StaggerX) {
+        if (staggerIndex == Map::StaggerEven)
+            return QPoint(hex.x, hex.z + (hex.x + (hex.x & 1)) / 2);
+        return QPoint(hex.x, hex.z + (hex.x - (hex.x & 1)) / 2);
+    }
+
+    if (staggerIndex == Map::StaggerEven)
+        return QPoint(hex.x + (hex.z + (hex.z & 1)) / 2, hex.z);
+    return QPoint(hex.x + (hex.z - (hex.z & 1)) / 2, hex.z);
+}
+
+CubeHex rotateHex(CubeHex hex, RotateDirection direction)
+{
+    if (direction == RotateLeft)
+        return CubeHex { -hex.y, -hex.z, -hex.x };
+    return CubeHex { -hex.z, -hex.x, -hex.y };
+}
+
+CubeHex operator-(CubeHex a, CubeHex b)
+{
+    return CubeHex { a.x - b.x, a.y - b.y, a.z - b.z };
+}
+
+CubeHex operator+(CubeHex a, CubeHex b)
+{
+    return CubeHex { a.x + b.x, a.y + b.y, a.z + b.z };
+}
+
+unsigned char hexMask(const Cell &cell)
+{
+    return (cell.flippedHorizontally() << 3) |
+            (cell.flippedVertically() << 2) |
+            (cell.flippedAntiDiagonally() << 1) |
+            (cell.rotatedHexagonal120() << 0);
+}
+
+void setHexMask(Cell &cell, unsigned char mask)
+{
+    cell.setFlippedHorizontally(mask & 8);
+    cell.setFlippedVertically(mask & 4);
+    cell.setFlippedAntiDiagonally(mask & 2);
+    cell.setRotatedHexagonal120(mask & 1);
+}
+
+std::unique_ptr<TileLayer> referenceFlip(const TileLayer &layer, FlipDirection direction)
+{
+    auto result = std::make_unique<TileLayer>(QString(), 0, 0, layer.width(), layer.height());
+
+    for (auto it = layer.begin(), it_end = layer.end(); it != it_end; ++it) {
+        Cell cell = it.value();
+        if (cell.isEmpty())
+            continue;
+
+        const QPoint pos = it.key();
+        if (direction == FlipHorizontally) {
+            cell.setFlippedHorizontally(!cell.flippedHorizontally());
+            result->setCell(layer.width() - pos.x() - 1, pos.y(), cell);
+        } else {
+            cell.setFlippedVertically(!cell.flippedVertically());
+            result->setCell(pos.x(), layer.height() - pos.y() - 1, cell);
+        }
+    }
+
+    return result;
+}
+
+std::unique_ptr<TileLayer> referenceFlipHexagonal(const TileLayer &layer, FlipDirection direction)
+{
+    static constexpr unsigned char flipMaskH[16] = { 8, 6, 5, 4, 12, 2, 1, 0, 0, 14, 13, 12, 4, 10, 9, 8 };
+    static constexpr unsigned char flipMaskV[16] = { 4, 10, 9, 8, 0, 14, 13, 12, 12, 2, 1, 0, 8, 6, 5, 4 };
+    const unsigned char (&flipMask)[16] = direction == FlipHorizontally ? flipMaskH : flipMaskV;
+
+    auto result = std::make_unique<TileLayer>(QString(), 0, 0, layer.width(), layer.height());
+
+    for (auto it = layer.begin(), it_end = layer.end(); it != it_end; ++it) {
+        Cell cell = it.value();
+        if (cell.isEmpty())
+            continue;
+
+        setHexMask(cell, flipMask[hexMask(cell)]);
+
+        const QPoint pos = it.key();
+        if (direction == FlipHorizontally)
+            result->setCell(layer.width() - pos.x() - 1, pos.y(), cell);
+        else
+            result->setCell(pos.x(), layer.height() - pos.y() - 1, cell);
+    }
+
+    return result;
+}
+
+std::unique_ptr<TileLayer> referenceRotate(const TileLayer &layer, RotateDirection direction)
+{
+    static constexpr unsigned char rotateRightMask[8] = { 5, 4, 1, 0, 7, 6, 3, 2 };
+    static constexpr unsigned char rotateLeftMask[8]  = { 3, 2, 7, 6, 1, 0, 5, 4 };
+    const unsigned char (&rotateMask)[8] = direction == RotateRight ? rotateRightMask : rotateLeftMask;
+
+    auto result = std::make_unique<TileLayer>(QString(), 0, 0, layer.height(), layer.width());
+
+    for (auto it = layer.begin(), it_end = layer.end(); it != it_end; ++it) {
+        Cell cell = it.value();
+        if (cell.isEmpty())
+            continue;
+
+        const unsigned char mask = rotateMask[(cell.flippedHorizontally() << 2) |
+                                              (cell.flippedVertically() << 1) |
+                                              (cell.flippedAntiDiagonally() << 0)];
+        cell.setFlippedHorizontally(mask & 4);
+        cell.setFlippedVertically(mask & 2);
+        cell.setFlippedAntiDiagonally(mask & 1);
+
+        const QPoint pos = it.key();
+        if (direction == RotateRight)
+            result->setCell(layer.height() - pos.y() - 1, pos.x(), cell);
+        else
+            result->setCell(pos.y(), layer.width() - pos.x() - 1, cell);
+    }
+
+    return result;
+}
+
+std::unique_ptr<TileLayer> referenceResize(const TileLayer &layer, QSize size, QPoint offset)
+{
+    if (layer.size() == size && offset.isNull())
+        return std::unique_ptr<TileLayer>(layer.clone());
+
+    auto result = std::make_unique<TileLayer>(QString(), 0, 0, size.width(), size.height());
+
+    const QRect area = layer.localBounds().translated(offset).intersected(result->rect());
+    for (int y = area.top(); y <= area.bottom(); ++y)
+        for (int x = area.left(); x <= area.right(); ++x)
+            result->setCell(x, y, layer.cellAt(x - offset.x(), y - offset.y()));
+
+    return result;
+}
+
+std::unique_ptr<TileLayer> referenceRotateHexagonal(const TileLayer &layer,
+                                                    RotateDirection direction,
+                                                    Map &map)
+{
+    static constexpr unsigned char rotateRightMask[16] = { 2, 12, 1, 14, 6, 8, 5, 10, 10,  4, 9, 0, 14,  0, 13,  2 };
+    static constexpr unsigned char rotateLeftMask[16]  = { 13, 2, 0,  1, 9, 6, 4,  5,  5, 10, 8, 9,  1, 14, 12, 13 };
+    const unsigned char (&rotateMask)[16] = direction == RotateRight ? rotateRightMask : rotateLeftMask;
+
+    const Map::StaggerIndex staggerIndex = map.staggerIndex();
+    const Map::StaggerAxis staggerAxis = map.staggerAxis();
+    const int width = layer.width();
+    const int height = layer.height();
+
+    const CubeHex center = hexFromStaggered(width / 2, height / 2, staggerIndex, staggerAxis);
+    const CubeHex bottomRight = rotateHex(hexFromStaggered(width, height, staggerIndex, staggerAxis) - center, RotateRight);
+    const CubeHex topRight = rotateHex(hexFromStaggered(width, 0, staggerIndex, staggerAxis) - center, RotateRight);
+
+    const int newWidth = hexToStaggered(topRight, staggerIndex, staggerAxis).x() * 2 + 2;
+    const int newHeight = hexToStaggered(bottomRight, staggerIndex, staggerAxis).y() * 2 + 2;
+    const CubeHex newCenter = hexFromStaggered(newWidth / 2, newHeight / 2, staggerIndex, staggerAxis);
+
+    TileLayer rotated(QString(), 0, 0, newWidth, newHeight);
+
+    for (auto it = layer.begin(), it_end = layer.end(); it != it_end; ++it) {
+        Cell cell = it.value();
+        if (cell.isEmpty())
+            continue;
+
+        setHexMask(cell, rotateMask[hexMask(cell)]);
+
+        const QPoint pos = it.key();
+        const CubeHex hex = rotateHex(hexFromStaggered(pos.x(), pos.y(), staggerIndex, staggerAxis) - center,
+                                      direction) + newCenter;
+        const QPoint rotatedPos = hexToStaggered(hex, staggerIndex, staggerAxis);
+        rotated.setCell(rotatedPos.x(), rotatedPos.y(), cell);
+    }
+
+    const QRect filledRect = rotated.region().boundingRect();
+    const int filledStart = staggerAxis == Map::StaggerY ? filledRect.y() : filledRect.x();
+    if (filledStart & 1)
+        map.invertStaggerIndex();
+
+    return referenceResize(rotated, filledRect.size(), -filledRect.topLeft());
+}
+
+int clampWrap(int value, int min, int max)
+{
+    const int v = value - min;
+    const int d = max - min;
+    return (v < 0 ? (v + 1) % d + d - 1 : v % d) + min;
+}
+
+std::unique_ptr<TileLayer> referenceOffsetTiles(const TileLayer &layer, QPoint offset,
+                                                QRect bounds, bool wrapX, bool wrapY)
+{
+    std::unique_ptr<TileLayer> result(layer.clone());
+    if (offset.isNull())
+        return result;
+
+    for (int y = bounds.top(); y <= bounds.bottom(); ++y) {
+        for (int x = bounds.left(); x <= bounds.right(); ++x) {
+            int oldX = x - offset.x();
+            int oldY = y - offset.y();
+
+            if (wrapX)
+                oldX = clampWrap(oldX, bounds.left(), bounds.right() + 1);
+            if (wrapY)
+                oldY = clampWrap(oldY, bounds.top(), bounds.bottom() + 1);
+
+            if (bounds.contains(oldX, oldY))
+                result->setCell(x, y, layer.cellAt(oldX, oldY));
+            else
+                result->setCell(x, y, Cell::empty);
+        }
+    }
+
+    return result;
+}
+
+std::unique_ptr<TileLayer> referenceOffsetTiles(const TileLayer &layer, QPoint offset)
+{
+    auto result = std::make_unique<TileLayer>(QString(), 0, 0, 0, 0);
+
+    for (auto it = layer.begin(), it_end = layer.end(); it != it_end; ++it) {
+        const QPoint pos = it.key() + offset;
+        result->setCell(pos.x(), pos.y(), it.value());
+    }
+
+    return result;
+}
+
+} // anonymous namespace
+
+class test_TileLayer : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+
+    void flip_data();
+    void flip();
+
+    void flipHexagonal_data();
+    void flipHexagonal();
+
+    void rotate_data();
+    void rotate();
+
+    void rotateHexagonal_data();
+    void rotateHexagonal();
+
+    void resize_data();
+    void resize();
+
+    void offsetTilesInBounds_data();
+    void offsetTilesInBounds();
+
+    void offsetTiles_data();
+    void offsetTiles();
+
+private:
+    std::unique_ptr<TileLayer> createLayer(QRect area, bool hexagonal = false) const;
+    static void compareCells(const TileLayer &actual, const TileLayer &expected);
+
+    SharedTileset mTileset1;
+    SharedTileset mTileset2;
+};
+
+void test_TileLayer::initTestCase()
+{
+    mTileset1 = Tileset::create(QStringLiteral("tiles1"), 16, 16);
+    mTileset2 = Tileset::create(QStringLiteral("tiles2"), 16, 16);
+    for (int id = 0; id < 8; ++id) {
+        mTileset1->findOrCreateTile(id);
+        mTileset2->findOrCreateTile(id);
+    }
+}
+
+/**
+ * Returns a 37x29 layer with random cells within \a area, which may extend
+ * beyond the layer to include negative chunk coordinates. About half the
+ * cells are filled, and every chunk is left partially empty.
+ */
+std::unique_ptr<TileLayer> test_TileLayer::createLayer(QRect area, bool hexagonal) const
+{
+    auto layer = std::make_unique<TileLayer>(QStringLiteral("layer"), 0, 0, 37, 29);
+
+    std::mt19937 random(area.width() * 31 + area.height());
+    std::bernoulli_distribution coin;
+    std::uniform_int_distribution<int> tileId(0, 7);
+
+    for (int y = area.top(); y <= area.bottom(); ++y) {
+        for (int x = area.left(); x <= area.right(); ++x) {
+            if (!coin(random) || (x & CHUNK_MASK) == 7)
+                continue;
+
+            Cell cell(coin(random) ? mTileset1.data() : mTileset2.data(), tileId(random));
+            cell.setFlippedHorizontally(coin(random));
+            cell.setFlippedVertically(coin(random));
+            cell.setFlippedAntiDiagonally(coin(random));
+            if (hexagonal)
+                cell.setRotatedHexagonal120(coin(random));
+
+            layer->setCell(x, y, cell);
+        }
+    }
+
+    return layer;
+}
+
+void test_TileLayer::compareCells(const TileLayer &actual, const TileLayer &expected)
+{
+    QCOMPARE(actual.size(), expected.size());
+    QCOMPARE(actual.region(), expected.region());
+
+    const QRect bounds = actual.localBounds().united(expected.localBounds());
+    for (int y = bounds.top(); y <= bounds.bottom(); ++y) {
+        for (int x = bounds.left(); x <= bounds.right(); ++x) {
+            const Cell &a = actual.cellAt(x, y);
+            const Cell &e = expected.cellAt(x, y);
+            if (a == e)
+                continue;
+
+            QFAIL(qPrintable(QStringLiteral("Cells differ at %1,%2").arg(x).arg(y)));
+        }
+    }
+}
+
+void test_TileLayer::flip_data()
+{
+    QTest::addColumn<int>("direction");
+
+    QTest::newRow("horizontally") << int(FlipHorizontally);
+    QTest::newRow("vertically") << int(FlipVertically);
+}
+
+void test_TileLayer::flip()
+{
+    QFETCH(int, direction);
+
+    auto layer = createLayer(QRect(-40, -35, 90, 80));
+    const auto expected = referenceFlip(*layer, FlipDirection(direction));
+
+    layer->flip(FlipDirection(direction));
+    compareCells(*layer, *expected);
+}
+
+void test_TileLayer::flipHexagonal_data()
+{
+    flip_data();
+}
+
+void test_TileLayer::flipHexagonal()
+{
+    QFETCH(int, direction);
+
+    auto layer = createLayer(QRect(-40, -35, 90, 80), true);
+    const auto expected = referenceFlipHexagonal(*layer, FlipDirection(direction));
+
+    layer->flipHexagonal(FlipDirection(direction));
+    compareCells(*layer, *expected);
+}
+
+void test_TileLayer::rotate_data()
+{
+    QTest::addColumn<int>("direction");
+
+    QTest::newRow("left") << int(RotateLeft);
+    QTest::newRow("right") << int(RotateRight);
+}
+
+void test_TileLayer::rotate()
+{
+    QFETCH(int, direction);
+
+    auto layer = createLayer(QRect(-40, -35, 90, 80));
+    const auto expected = referenceRotate(*layer, RotateDirection(direction));
+
+    layer->rotate(RotateDirection(direction));
+    compareCells(*layer, *expected);
+}
+
+void test_TileLayer::rotateHexagonal_data()
+{
+    QTest::addColumn<int>("direction");
+    QTest::addColumn<int>("staggerAxis");
+    QTest::addColumn<int>("staggerIndex");
+
+    for (const int direction : { RotateLeft, RotateRight }) {
+        for (const int staggerAxis : { Map::StaggerX, Map::StaggerY }) {
+            for (const int staggerIndex : { Map::StaggerOdd, Map::StaggerEven }) {
+                QTest::addRow("%s-%s-%s",
+                              direction == RotateLeft ? "left" : "right",
+                              staggerAxis == Map::StaggerX ? "x" : "y",
+                              staggerIndex == Map::StaggerOdd ? "odd" : "even")
+                        << direction << staggerAxis << staggerIndex;
+            }
+        }
+    }
+}
+
+void test_TileLayer::rotateHexagonal()
+{
+    QFETCH(int, direction);
+    QFETCH(int, staggerAxis);
+    QFETCH(int, staggerIndex);
+
+    Map::Parameters parameters;
+    parameters.orientation = Map::Hexagonal;
+    parameters.width = 37;
+    parameters.height = 29;
+    parameters.tileWidth = 16;
+    parameters.tileHeight = 16;
+    parameters.staggerAxis = Map::StaggerAxis(staggerAxis);
+    parameters.staggerIndex = Map::StaggerIndex(staggerIndex);
+
+    Map map(parameters);
+    Map referenceMap(parameters);
+
+    auto layer = createLayer(QRect(0, 0, 37, 29), true);
+    const auto expected = referenceRotateHexagonal(*layer, RotateDirection(direction), referenceMap);
+
+    layer->rotateHexagonal(RotateDirection(direction), &map);
+    compareCells(*layer, *expected);
+    QCOMPARE(map.staggerIndex(), referenceMap.staggerIndex());
+}
+
+void test_TileLayer::resize_data()
+{
+    QTest::addColumn<QSize>("size");
+    QTest::addColumn<QPoint>("offset");
+
+    QTest::newRow("grow") << QSize(60, 50) << QPoint(0, 0);
+    QTest::newRow("shrink") << QSize(20, 10) << QPoint(0, 0);
+    QTest::newRow("aligned") << QSize(80, 70) << QPoint(16, 32);
+    QTest::newRow("aligned-negative") << QSize(37, 29) << QPoint(-16, -32);
+    QTest::newRow("non-aligned") << QSize(60, 50) << QPoint(5, 3);
+    QTest::newRow("non-aligned-negative") << QSize(30, 20) << QPoint(-7, -18);
+
+    // The chunks moved to (16, 16) are only partially within the new size
+    QTest::newRow("aligned-clipped") << QSize(25, 21) << QPoint(16, 16);
+}
+
+void test_TileLayer::resize()
+{
+    QFETCH(QSize, size);
+    QFETCH(QPoint, offset);
+
+    auto layer = createLayer(QRect(-40, -35, 90, 80));
+    const auto expected = referenceResize(*layer, size, offset);
+
+    layer->resize(size, offset);
+    compareCells(*layer, *expected);
+
+    // Nothing remains outside of the new size
+    QVERIFY(QRect(QPoint(), size).contains(layer->region().boundingRect()) ||
+            layer->region().isEmpty());
+}
+
+void test_TileLayer::offsetTilesInBounds_data()
+{
+    QTest::addColumn<QPoint>("offset");
+    QTest::addColumn<QRect>("bounds");
+    QTest::addColumn<bool>("wrapX");
+    QTest::addColumn<bool>("wrapY");
+
+    const QRect layerRect(0, 0, 37, 29);
+    const QRect aligned(16, 0, 32, 32);
+    const QRect unaligned(3, 2, 30, 20);
+
+    QTest::newRow("aligned") << QPoint(16, -16) << layerRect << false << false;
+    QTest::newRow("aligned-wrap") << QPoint(16, -16) << layerRect << true << true;
+    QTest::newRow("aligned-bounds") << QPoint(-16, 16) << aligned << false << false;
+    QTest::newRow("aligned-bounds-wrap") << QPoint(-16, 16) << aligned << true << true;
+    QTest::newRow("non-aligned") << QPoint(5, -3) << layerRect << false << false;
+    QTest::newRow("non-aligned-wrap-x") << QPoint(5, -3) << layerRect << true << false;
+    QTest::newRow("non-aligned-wrap-y") << QPoint(5, -3) << layerRect << false << true;
+    QTest::newRow("non-aligned-bounds") << QPoint(-4, 7) << unaligned << false << false;
+    QTest::newRow("non-aligned-bounds-wrap") << QPoint(-4, 7) << unaligned << true << true;
+    QTest::newRow("wrap-edge") << QPoint(-1, 1) << unaligned << true << true;
+    QTest::newRow("wrap-larger-than-bounds") << QPoint(47, -65) << unaligned << true << true;
+    QTest::newRow("beyond-bounds") << QPoint(47, -65) << unaligned << false << false;
+}
+
+void test_TileLayer::offsetTilesInBounds()
+{
+    QFETCH(QPoint, offset);
+    QFETCH(QRect, bounds);
+    QFETCH(bool, wrapX);
+    QFETCH(bool, wrapY);
+
+    // Also includes cells outside of the bounds, which are left alone
+    auto layer = createLayer(QRect(-20, -20, 80, 70));
+    const auto expected = referenceOffsetTiles(*layer, offset, bounds, wrapX, wrapY);
+
+    layer->offsetTiles(offset, bounds, wrapX, wrapY);
+    compareCells(*layer, *expected);
+}
+
+void test_TileLayer::offsetTiles_data()
+{
+    QTest::addColumn<QPoint>("offset");
+
+    QTest::newRow("aligned") << QPoint(16, -32);
+    QTest::newRow("non-aligned") << QPoint(5, -3);
+    QTest::newRow("non-aligned-negative") << QPoint(-21, 7);
+}
+
+void test_TileLayer::offsetTiles()
+{
+    QFETCH(QPoint, offset);
+
+    auto layer = createLayer(QRect(-40, -35, 90, 80));
+    const auto expected = referenceOffsetTiles(*layer, offset);
+
+    layer->offsetTiles(offset);
+    compareCells(*layer, *expected);
+}
+
+QTEST_MAIN(test_TileLayer)
+#include "test_tilelayer.moc"
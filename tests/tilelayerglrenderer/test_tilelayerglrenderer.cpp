@@ -0,0 +1,165 @@
+#include "map.h"
+#include "orthogonalrenderer.h"
+#include "tilelayer.h"
+#include "tilelayerglrenderer.h"
+#include "tileset.h"
+
+#include <QOffscreenSurface>
+#include <QOpenGLContext>
+#include <QOpenGLFramebufferObject>
+#include <QOpenGLPaintDevice>
+#include <QPainter>
+#include <QtTest/QtTest>
+
+using namespace Tiled;
+
+class test_TileLayerGLRenderer : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void matchesRasterRendering();
+    void updatesInvalidatedChunks();
+
+private:
+    QImage renderRaster() const;
+    QImage renderOpenGL(TileLayerGLRenderer &glRenderer) const;
+
+    std::unique_ptr<Map> mMap;
+    TileLayer *mTileLayer = nullptr;
+    std::unique_ptr<OrthogonalRenderer> mRenderer;
+    QOffscreenSurface mSurface;
+    QOpenGLContext mContext;
+};
+
+void test_TileLayerGLRenderer::initTestCase()
+{
+    // Works with a software implementation like llvmpipe, for example when
+    // running with QT_QPA_PLATFORM=offscreen and LIBGL_ALWAYS_SOFTWARE=1.
+    mSurface.create();
+    if (!mContext.create() || !mContext.makeCurrent(&mSurface))
+        QSKIP("OpenGL is not available");
+    if (mContext.format().profile() == QSurfaceFormat::CoreProfile)
+        QSKIP("The OpenGL tile layer renderer requires a compatibility profile");
+
+    // Opaque tiles, with a marker in their top-left corner to detect flipping
+    QImage tilesetImage(64, 64, QImage::Format_ARGB32);
+    QPainter painter(&tilesetImage);
+    for (int y = 0; y < 4; ++y) {
+        for (int x = 0; x < 4; ++x) {
+            painter.fillRect(x * 16, y * 16, 16, 16, QColor(x * 64, y * 64, 128));
+            painter.fillRect(x * 16, y * 16, 4, 8, Qt::white);
+        }
+    }
+    painter.end();
+
+    Map::Parameters mapParameters;
+    mapParameters.width = 40;
+    mapParameters.height = 40;
+    mapParameters.tileWidth = 16;
+    mapParameters.tileHeight = 16;
+    mMap = std::make_unique<Map>(mapParameters);
+
+    SharedTileset tileset = Tileset::create(QStringLiteral("tiles"), 16, 16);
+    QVERIFY(tileset->loadFromImage(tilesetImage, QStringLiteral("tiles.png")));
+    mMap->addTileset(tileset);
+
+    mTileLayer = new TileLayer(QString(), 0, 0, mMap->width(), mMap->height());
+    mMap->addLayer(mTileLayer);
+
+    for (int y = 0; y < mMap->height(); ++y) {
+        for (int x = 0; x < mMap->width(); ++x) {
+            if ((x + y) % 7 == 0)
+                continue;   // leave some cells empty
+
+            Cell cell(tileset->findTile((x * 3 + y) % tileset->tileCount()));
+            cell.setFlippedHorizontally(x % 2);
+            cell.setFlippedVertically(y % 3 == 0);
+            cell.setFlippedAntiDiagonally(x % 5 == 0);
+            mTileLayer->setCell(x, y, cell);
+        }
+    }
+
+    mRenderer = std::make_unique<OrthogonalRenderer>(mMap.get());
+}
+
+void test_TileLayerGLRenderer::cleanupTestCase()
+{
+    mRenderer.reset();
+    mMap.reset();
+    mContext.doneCurrent();
+}
+
+QImage test_TileLayerGLRenderer::renderRaster() const
+{
+    QImage image(mRenderer->mapBoundingRect().size(), QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::transparent);
+
+    QPainter painter(&image);
+    mRenderer->drawTileLayer(&painter, mTileLayer);
+    painter.end();
+
+    return image;
+}
+
+QImage test_TileLayerGLRenderer::renderOpenGL(TileLayerGLRenderer &glRenderer) const
+{
+    const QSize size = mRenderer->mapBoundingRect().size();
+
+    QOpenGLFramebufferObject framebuffer(size);
+    framebuffer.bind();
+
+    QOpenGLPaintDevice device(size);
+    QPainter painter(&device);
+    painter.setCompositionMode(QPainter::CompositionMode_Source);
+    painter.fillRect(QRect(QPoint(), size), Qt::transparent);
+    painter.setCompositionMode(QPainter::CompositionMode_SourceOver);
+
+    // Returns a null image when the OpenGL renderer can't be used
+    const bool canRender = glRenderer.canRender(&painter, mRenderer.get());
+    if (canRender)
+        glRenderer.render(&painter, mRenderer.get(), QRectF());
+
+    painter.end();
+    framebuffer.release();
+
+    if (!canRender)
+        return QImage();
+
+    return framebuffer.toImage().convertToFormat(QImage::Format_ARGB32_Premultiplied);
+}
+
+void test_TileLayerGLRenderer::matchesRasterRendering()
+{
+    TileLayerGLRenderer glRenderer(mTileLayer);
+
+    const QImage image = renderOpenGL(glRenderer);
+    QVERIFY2(!image.isNull(), "TileLayerGLRenderer::canRender returned false");
+    QCOMPARE(image, renderRaster());
+}
+
+void test_TileLayerGLRenderer::updatesInvalidatedChunks()
+{
+    TileLayerGLRenderer glRenderer(mTileLayer);
+
+    const QImage image = renderOpenGL(glRenderer);
+    QVERIFY2(!image.isNull(), "TileLayerGLRenderer::canRender returned false");
+    QCOMPARE(image, renderRaster());
+
+    const Cell cell = mTileLayer->cellAt(1, 1);
+    const QRegion changed(17, 20, 5, 3);
+    for (const QRect &rect : changed)
+        for (int y = rect.top(); y <= rect.bottom(); ++y)
+            for (int x = rect.left(); x <= rect.right(); ++x)
+                mTileLayer->setCell(x, y, cell);
+
+    glRenderer.invalidate(changed);
+
+    QCOMPARE(renderOpenGL(glRenderer), renderRaster());
+}
+
+QTEST_MAIN(test_TileLayerGLRenderer)
+#include "test_tilelayerglrenderer.moc"